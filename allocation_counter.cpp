@@ -0,0 +1,75 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<bool> countingEnabled(false);
+static std::atomic<size_t> allocationCount(0);
+static std::atomic<size_t> deallocationCount(0);
+static std::atomic<size_t> allocatedBytes(0);
+
+void startAllocationCounting() {
+    allocationCount.store(0, std::memory_order_relaxed);
+    deallocationCount.store(0, std::memory_order_relaxed);
+    allocatedBytes.store(0, std::memory_order_relaxed);
+    countingEnabled.store(true, std::memory_order_relaxed);
+}
+
+AllocationCounts stopAllocationCounting() {
+    countingEnabled.store(false, std::memory_order_relaxed);
+    return {allocationCount.load(std::memory_order_relaxed), deallocationCount.load(std::memory_order_relaxed),
+            allocatedBytes.load(std::memory_order_relaxed)};
+}
+
+static void countAllocation(std::size_t size) {
+    if (countingEnabled.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+static void countDeallocation(void *p) {
+    if (p && countingEnabled.load(std::memory_order_relaxed)) {
+        deallocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void *operator new(std::size_t size) {
+    countAllocation(size);
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    countAllocation(size);
+    // aligned_alloc wants a non-zero multiple of the alignment.
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t rounded = size ? (size + align - 1) / align * align : align;
+    if (void *p = std::aligned_alloc(align, rounded)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    countDeallocation(p);
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    countDeallocation(p);
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+    countDeallocation(p);
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    countDeallocation(p);
+    std::free(p);
+}
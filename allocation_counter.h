@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+struct AllocationCounts {
+    size_t allocations;
+    size_t deallocations;
+    size_t bytes;
+};
+
+// Counts every global operator new/delete between the two calls, from all threads.
+void startAllocationCounting();
+AllocationCounts stopAllocationCounting();
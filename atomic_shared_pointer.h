@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include "hazard_pointer.h"
+#include "shared_pointer.h"
+
+// A SharedPointer slot that threads can read and replace concurrently without a
+// lock. The current value lives in an immutable snapshot node; a reader protects
+// the node with a hazard pointer and copies the SharedPointer out of it, and a
+// writer swaps in a new node and retires the old one, whose reference is only
+// dropped once no reader can still be copying it.
+template<typename T>
+class AtomicSharedPointer {
+
+private:
+
+    using Pointer = SharedPointer<T, AtomicCounting>;
+
+    struct Snapshot {
+
+        Pointer value;
+
+        explicit Snapshot(Pointer p) : value(std::move(p)) {}
+    };
+
+    std::atomic<Snapshot*> snapshot;
+
+    static Snapshot* wrap(Pointer&& value) {
+        return value.null() ? nullptr : new Snapshot(std::move(value));
+    }
+
+    static bool same(const Pointer& a, const Pointer& b) {
+        return a.get() == b.get() && a.control_block() == b.control_block();
+    }
+
+    // Returns the current snapshot with a hazard pointer on it; the caller clears it.
+    Snapshot* acquire() const {
+        Snapshot* current = snapshot.load(std::memory_order_acquire);
+        while (true) {
+            HazardPointers::protect(current);
+            Snapshot* again = snapshot.load(std::memory_order_seq_cst);
+            if (again == current) {
+                return current;
+            }
+            current = again;
+        }
+    }
+
+    static void retire(Snapshot* old) {
+        if (old) {
+            HazardPointers::retire(old);
+        }
+    }
+
+public:
+
+    AtomicSharedPointer() : snapshot(nullptr) {}
+
+    explicit AtomicSharedPointer(Pointer value) : snapshot(wrap(std::move(value))) {}
+
+    AtomicSharedPointer(const AtomicSharedPointer&) = delete;
+    AtomicSharedPointer& operator=(const AtomicSharedPointer&) = delete;
+
+    ~AtomicSharedPointer() {
+        delete snapshot.load(std::memory_order_acquire);
+    }
+
+    Pointer load() const {
+        Snapshot* current = acquire();
+        Pointer result = current ? current->value : Pointer();
+        HazardPointers::clear();
+        return result;
+    }
+
+    void store(Pointer desired) {
+        retire(snapshot.exchange(wrap(std::move(desired)), std::memory_order_acq_rel));
+    }
+
+    Pointer exchange(Pointer desired) {
+        Snapshot* old = snapshot.exchange(wrap(std::move(desired)), std::memory_order_acq_rel);
+        // Readers may still be copying old->value, so it is copied rather than moved out.
+        Pointer result = old ? old->value : Pointer();
+        retire(old);
+        return result;
+    }
+
+    // Replaces the value with desired if it still points where expected does;
+    // otherwise loads the current value into expected and returns false.
+    bool compare_exchange(Pointer& expected, Pointer desired) {
+        Snapshot* replacement = wrap(std::move(desired));
+        while (true) {
+            Snapshot* current = acquire();
+            const Pointer empty;
+            const Pointer& value = current ? current->value : empty;
+            if (!same(value, expected)) {
+                expected = value;
+                HazardPointers::clear();
+                delete replacement;
+                return false;
+            }
+            if (snapshot.compare_exchange_strong(current, replacement, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire)) {
+                HazardPointers::clear();
+                retire(current);
+                return true;
+            }
+            HazardPointers::clear();
+        }
+    }
+};
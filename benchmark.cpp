@@ -0,0 +1,125 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+Benchmark::Benchmark(int warmups, int samples) : warmupIterations(warmups), sampleIterations(samples) {}
+
+static int warmupOverride = -1;
+static int sampleOverride = -1;
+
+Benchmark Benchmark::forSize(size_t operations) {
+    size_t samples = 20'000'000 / std::max<size_t>(operations, 1);
+    return Benchmark(warmupOverride >= 0 ? warmupOverride : 1,
+                     sampleOverride > 0 ? sampleOverride : int(std::clamp<size_t>(samples, 3, 30)));
+}
+
+void Benchmark::setRepetitions(int warmups, int samples) {
+    warmupOverride = warmups;
+    sampleOverride = samples;
+}
+
+void Benchmark::record(const BenchmarkSample &sample) {
+    for (const auto &timing : sample.timings) {
+        auto found = std::find(phases.begin(), phases.end(), timing.phase);
+        size_t index = found - phases.begin();
+        if (found == phases.end()) {
+            phases.push_back(timing.phase);
+            timings.emplace_back();
+            allocations.emplace_back();
+            perfTotals.emplace_back();
+        }
+        timings[index].push_back(timing.nanoseconds);
+        allocations[index] = timing;
+        for (size_t counter = 0; counter < perfCounterCount; ++counter) {
+            double &total = perfTotals[index][counter];
+            total = timing.perf[counter] < 0 || total < 0 ? -1 : total + timing.perf[counter];
+        }
+    }
+}
+
+std::vector<PhaseStatistics> Benchmark::statistics() const {
+    std::vector<PhaseStatistics> result;
+
+    for (size_t i = 0; i < phases.size(); ++i) {
+        std::vector<double> values = timings[i];
+        std::sort(values.begin(), values.end());
+        size_t count = values.size();
+
+        double mean = 0;
+        for (double value : values) {
+            mean += value;
+        }
+        mean /= double(count);
+
+        double variance = 0;
+        for (double value : values) {
+            variance += (value - mean) * (value - mean);
+        }
+        variance = count > 1 ? variance / double(count - 1) : 0;
+
+        double median = count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+        size_t p99Rank = size_t(std::ceil(0.99 * double(count)));
+
+        PerfCounts perf = perfTotals[i];
+        for (double &value : perf) {
+            value = value < 0 ? value : value / double(count);
+        }
+
+        result.push_back({phases[i], count, values.front(), median, values[std::max<size_t>(p99Rank, 1) - 1],
+                          std::sqrt(variance), allocations[i].allocations, allocations[i].deallocations,
+                          allocations[i].bytes, perf});
+    }
+
+    return result;
+}
+
+static void printPerfCounts(const PerfCounts &perf) {
+    std::cout << "     ";
+    for (size_t counter = 0; counter < perfCounterCount; ++counter) {
+        std::cout << " " << perfCounterName(counter) << " ";
+        if (perf[counter] < 0) {
+            std::cout << "n/a";
+        } else {
+            std::cout << perf[counter];
+        }
+        std::cout << (counter + 1 < perfCounterCount ? "," : " per op");
+    }
+    if (perf[perfCycles] > 0 && perf[perfInstructions] >= 0) {
+        std::cout << ", IPC " << perf[perfInstructions] / perf[perfCycles];
+    }
+    std::cout << "\n";
+}
+
+void printPhaseStatistics(const std::vector<PhaseStatistics> &statistics) {
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+
+    std::cout << "\n" << std::fixed << std::setprecision(2);
+    for (const auto &phase : statistics) {
+        std::cout << "    " << phase.phase << ": min " << phase.min << ", median " << phase.median
+                  << ", p99 " << phase.p99 << ", stddev " << phase.stddev << " ns/op, "
+                  << phase.allocations << " allocations, " << phase.bytes << " bytes, "
+                  << phase.deallocations << " frees per op (" << phase.samples << " samples)\n";
+        if (phase.perf[perfCycles] >= 0 || phase.perf[perfInstructions] >= 0) {
+            printPerfCounts(phase.perf);
+        }
+    }
+
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+void printAllocationsPerOperation(const AllocationCounts &counts, size_t operations) {
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    double divisor = double(operations ? operations : 1);
+
+    std::cout << std::fixed << std::setprecision(2) << double(counts.allocations) / divisor << " allocations, "
+              << double(counts.bytes) / divisor << " bytes, " << double(counts.deallocations) / divisor << " frees per op";
+
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "perf_counters.h"
+
+// Keeps the compiler from discarding a value whose computation is being measured.
+template<typename T>
+inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+struct PhaseStatistics {
+    std::string phase;
+    size_t samples;
+    double min;
+    double median;
+    double p99;
+    double stddev;
+    double allocations;
+    double deallocations;
+    double bytes;
+    PerfCounts perf;
+};
+
+struct PhaseTiming {
+    std::string phase;
+    double nanoseconds;
+    double allocations;
+    double deallocations;
+    double bytes;
+    PerfCounts perf;
+};
+
+class BenchmarkSample {
+
+private:
+
+    std::vector<PhaseTiming> timings;
+
+    friend class Benchmark;
+
+public:
+
+    template<typename Operation>
+    void measure(const std::string &phase, size_t operations, Operation operation) {
+        startAllocationCounting();
+        startPerfCounters();
+        auto start = std::chrono::steady_clock::now();
+        operation();
+        auto end = std::chrono::steady_clock::now();
+        PerfCounts perf = stopPerfCounters();
+        AllocationCounts counts = stopAllocationCounting();
+
+        double nanoseconds = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        double divisor = double(operations ? operations : 1);
+        for (double &value : perf) {
+            value = value < 0 ? value : value / divisor;
+        }
+        timings.push_back({phase, nanoseconds / divisor, double(counts.allocations) / divisor,
+                           double(counts.deallocations) / divisor, double(counts.bytes) / divisor, perf});
+    }
+};
+
+class Benchmark {
+
+private:
+
+    int warmupIterations;
+    int sampleIterations;
+    std::vector<std::string> phases;
+    std::vector<std::vector<double>> timings;
+    std::vector<PhaseTiming> allocations;
+    std::vector<PerfCounts> perfTotals;
+
+    void record(const BenchmarkSample &sample);
+
+public:
+
+    Benchmark(int warmups, int samples);
+
+    // Fewer repetitions for bigger workloads so every size takes comparable time,
+    // unless overridden with setRepetitions.
+    static Benchmark forSize(size_t operations);
+
+    // A negative value restores the size-based default.
+    static void setRepetitions(int warmups, int samples);
+
+    template<typename Body>
+    void run(Body body) {
+        for (int i = 0; i < warmupIterations; ++i) {
+            BenchmarkSample sample;
+            body(sample);
+        }
+        for (int i = 0; i < sampleIterations; ++i) {
+            BenchmarkSample sample;
+            body(sample);
+            record(sample);
+        }
+    }
+
+    std::vector<PhaseStatistics> statistics() const;
+};
+
+void printPhaseStatistics(const std::vector<PhaseStatistics> &statistics);
+
+// Prints "a allocations, b bytes, c frees per op" for counts taken over the given number of operations.
+void printAllocationsPerOperation(const AllocationCounts &counts, size_t operations);
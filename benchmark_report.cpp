@@ -0,0 +1,276 @@
+#include "benchmark_report.h"
+#include "memory_usage.h"
+
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+static std::vector<BenchmarkRecord> records;
+
+void recordBenchmark(const std::string &variant, size_t size, const std::vector<PhaseStatistics> &statistics,
+                     size_t threads) {
+    size_t peakResident = peakResidentMemory();
+    for (const auto &phase : statistics) {
+        records.push_back({variant, size, threads, phase.phase, phase.median, phase.min, phase.p99, phase.stddev,
+                           phase.allocations, phase.deallocations, phase.bytes, peakResident, phase.perf});
+    }
+    // The next record then reports the peak reached since this one, starting from
+    // a heap trimmed of what this benchmark freed.
+    releaseFreeMemory();
+    resetPeakResidentMemory();
+}
+
+const std::vector<BenchmarkRecord> &recordedBenchmarks() {
+    return records;
+}
+
+static const char *csvHeader = "variant,size,threads,phase,ns_per_op,min_ns,p99_ns,stddev_ns,allocations_per_op,frees_per_op,bytes_per_op,peak_rss_bytes";
+
+static std::string perfFieldName(size_t counter) {
+    return std::string(perfCounterName(counter)) + "_per_op";
+}
+
+static void writeJson(std::ostream &out, const std::vector<BenchmarkRecord> &records) {
+    out << "[\n";
+    for (size_t i = 0; i < records.size(); ++i) {
+        const BenchmarkRecord &record = records[i];
+        out << "  {\"variant\": \"" << record.variant << "\", \"size\": " << record.size
+            << ", \"threads\": " << record.threads
+            << ", \"phase\": \"" << record.phase << "\", \"ns_per_op\": " << record.nanosecondsPerOperation
+            << ", \"min_ns\": " << record.minNanoseconds << ", \"p99_ns\": " << record.p99Nanoseconds
+            << ", \"stddev_ns\": " << record.stddevNanoseconds
+            << ", \"allocations_per_op\": " << record.allocationsPerOperation
+            << ", \"frees_per_op\": " << record.deallocationsPerOperation
+            << ", \"bytes_per_op\": " << record.bytesPerOperation
+            << ", \"peak_rss_bytes\": " << record.peakResidentBytes;
+        for (size_t counter = 0; counter < perfCounterCount; ++counter) {
+            if (record.perfPerOperation[counter] >= 0) {
+                out << ", \"" << perfFieldName(counter) << "\": " << record.perfPerOperation[counter];
+            }
+        }
+        out << "}" << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
+
+static void writeCsv(std::ostream &out, const std::vector<BenchmarkRecord> &records) {
+    out << csvHeader;
+    for (size_t counter = 0; counter < perfCounterCount; ++counter) {
+        out << "," << perfFieldName(counter);
+    }
+    out << "\n";
+    for (const auto &record : records) {
+        out << record.variant << "," << record.size << "," << record.threads << "," << record.phase << ","
+            << record.nanosecondsPerOperation << "," << record.minNanoseconds << "," << record.p99Nanoseconds << ","
+            << record.stddevNanoseconds << "," << record.allocationsPerOperation << ","
+            << record.deallocationsPerOperation << "," << record.bytesPerOperation << ","
+            << record.peakResidentBytes;
+        for (double value : record.perfPerOperation) {
+            out << ",";
+            if (value >= 0) {
+                out << value;
+            }
+        }
+        out << "\n";
+    }
+}
+
+void writeBenchmarkRecords(const std::vector<BenchmarkRecord> &records, const std::string &path,
+                           const std::string &format) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("cannot open " + path + " for writing");
+    }
+    out << std::setprecision(10);
+
+    if (format == "json") {
+        writeJson(out, records);
+    } else if (format == "csv") {
+        writeCsv(out, records);
+    } else {
+        throw std::runtime_error("unknown output format " + format);
+    }
+}
+
+static BenchmarkRecord recordFromFields(const std::map<std::string, std::string> &fields) {
+    auto field = [&fields](const char *name) -> const std::string & {
+        auto found = fields.find(name);
+        if (found == fields.end()) {
+            throw std::runtime_error(std::string("missing field ") + name);
+        }
+        return found->second;
+    };
+
+    // Fields added after the first format version default when absent.
+    auto optional = [&fields](const char *name, const char *fallback) {
+        auto found = fields.find(name);
+        return found == fields.end() ? std::string(fallback) : found->second;
+    };
+
+    PerfCounts perf;
+    for (size_t counter = 0; counter < perfCounterCount; ++counter) {
+        std::string value = optional(perfFieldName(counter).c_str(), "");
+        perf[counter] = value.empty() ? -1 : std::stod(value);
+    }
+
+    return {field("variant"), std::stoul(field("size")), std::stoul(optional("threads", "1")),
+            field("phase"), std::stod(field("ns_per_op")),
+            std::stod(field("min_ns")), std::stod(field("p99_ns")), std::stod(field("stddev_ns")),
+            std::stod(field("allocations_per_op")), std::stod(optional("frees_per_op", "0")),
+            std::stod(optional("bytes_per_op", "0")), std::stoul(field("peak_rss_bytes")), perf};
+}
+
+// Reads the flat array of flat objects produced by writeJson.
+static std::vector<BenchmarkRecord> readJson(const std::string &text) {
+    std::vector<BenchmarkRecord> result;
+    size_t position = 0;
+
+    auto skipSpaces = [&]() {
+        while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) {
+            ++position;
+        }
+    };
+    auto expect = [&](char c) {
+        skipSpaces();
+        if (position >= text.size() || text[position] != c) {
+            throw std::runtime_error(std::string("malformed JSON, expected '") + c + "'");
+        }
+        ++position;
+    };
+    auto readValue = [&]() {
+        skipSpaces();
+        std::string value;
+        if (position < text.size() && text[position] == '"') {
+            ++position;
+            while (position < text.size() && text[position] != '"') {
+                value += text[position++];
+            }
+            expect('"');
+        } else {
+            while (position < text.size() && text[position] != ',' && text[position] != '}'
+                   && !std::isspace(static_cast<unsigned char>(text[position]))) {
+                value += text[position++];
+            }
+        }
+        return value;
+    };
+
+    expect('[');
+    skipSpaces();
+    while (position < text.size() && text[position] != ']') {
+        std::map<std::string, std::string> fields;
+        expect('{');
+        skipSpaces();
+        while (position < text.size() && text[position] != '}') {
+            std::string name = readValue();
+            expect(':');
+            fields[name] = readValue();
+            skipSpaces();
+            if (position < text.size() && text[position] == ',') {
+                ++position;
+                skipSpaces();
+            }
+        }
+        expect('}');
+        result.push_back(recordFromFields(fields));
+        skipSpaces();
+        if (position < text.size() && text[position] == ',') {
+            ++position;
+            skipSpaces();
+        }
+    }
+    expect(']');
+
+    return result;
+}
+
+static std::vector<BenchmarkRecord> readCsv(std::istream &in) {
+    std::vector<BenchmarkRecord> result;
+    std::string line;
+    std::vector<std::string> header;
+
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::vector<std::string> cells;
+        std::stringstream stream(line);
+        std::string cell;
+        while (std::getline(stream, cell, ',')) {
+            cells.push_back(cell);
+        }
+
+        if (header.empty()) {
+            header = cells;
+            continue;
+        }
+        std::map<std::string, std::string> fields;
+        for (size_t i = 0; i < header.size() && i < cells.size(); ++i) {
+            fields[header[i]] = cells[i];
+        }
+        result.push_back(recordFromFields(fields));
+    }
+
+    return result;
+}
+
+std::vector<BenchmarkRecord> readBenchmarkRecords(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first != std::string::npos && text[first] == '[') {
+        return readJson(text);
+    }
+    std::stringstream csv(text);
+    return readCsv(csv);
+}
+
+int compareBenchmarkRecords(const std::vector<BenchmarkRecord> &baseline, const std::vector<BenchmarkRecord> &current,
+                            double thresholdPercent) {
+    std::map<std::tuple<std::string, size_t, size_t, std::string>, const BenchmarkRecord *> baselineByKey;
+    for (const auto &record : baseline) {
+        baselineByKey[{record.variant, record.size, record.threads, record.phase}] = &record;
+    }
+
+    int regressions = 0;
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (const auto &record : current) {
+        auto found = baselineByKey.find({record.variant, record.size, record.threads, record.phase});
+        std::string name = record.variant + " " + std::to_string(record.size)
+                           + (record.threads > 1 ? " x" + std::to_string(record.threads) : "") + " " + record.phase;
+        if (found == baselineByKey.end()) {
+            std::cout << name << ": no baseline\n";
+            continue;
+        }
+        const BenchmarkRecord &before = *found->second;
+        double change = before.nanosecondsPerOperation > 0
+                        ? (record.nanosecondsPerOperation / before.nanosecondsPerOperation - 1) * 100 : 0;
+        bool regression = change > thresholdPercent;
+        regressions += regression;
+
+        std::cout << name << ": " << before.nanosecondsPerOperation << " -> " << record.nanosecondsPerOperation << " ns/op ("
+                  << (change >= 0 ? "+" : "") << change << "%)";
+        if (std::abs(record.allocationsPerOperation - before.allocationsPerOperation) >= 0.005) {
+            std::cout << ", allocations/op " << before.allocationsPerOperation << " -> " << record.allocationsPerOperation;
+        }
+        std::cout << (regression ? " REGRESSION" : "") << "\n";
+    }
+
+    std::cout.flags(flags);
+    std::cout << regressions << " regression(s) above " << thresholdPercent << "%\n";
+    return regressions;
+}
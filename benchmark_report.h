@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+struct BenchmarkRecord {
+    std::string variant;
+    size_t size;
+    size_t threads;
+    std::string phase;
+    double nanosecondsPerOperation;
+    double minNanoseconds;
+    double p99Nanoseconds;
+    double stddevNanoseconds;
+    double allocationsPerOperation;
+    double deallocationsPerOperation;
+    double bytesPerOperation;
+    size_t peakResidentBytes;
+    PerfCounts perfPerOperation;
+};
+
+void recordBenchmark(const std::string &variant, size_t size, const std::vector<PhaseStatistics> &statistics,
+                     size_t threads = 1);
+const std::vector<BenchmarkRecord> &recordedBenchmarks();
+
+// Format is "json" or "csv"; throws std::runtime_error when the file cannot be written.
+void writeBenchmarkRecords(const std::vector<BenchmarkRecord> &records, const std::string &path,
+                           const std::string &format);
+
+// Accepts both formats written above; throws std::runtime_error on unreadable input.
+std::vector<BenchmarkRecord> readBenchmarkRecords(const std::string &path);
+
+// Prints every matching record and returns how many got slower than the baseline
+// by more than thresholdPercent.
+int compareBenchmarkRecords(const std::vector<BenchmarkRecord> &baseline, const std::vector<BenchmarkRecord> &current,
+                            double thresholdPercent);
@@ -0,0 +1,318 @@
+#include "command_line.h"
+#include "benchmark.h"
+#include "benchmark_report.h"
+#include "load_tests.h"
+#include "perf_counters.h"
+
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct BenchmarkVariant {
+    const char *name;
+    const char *description;
+    void (*run)(int testSize, const std::vector<int> &threadCounts);
+};
+
+static const BenchmarkVariant variants[] = {
+        {"unique_pointer", "UniquePointer in a vector", [](int testSize, const std::vector<int> &) {
+            loadUniquePointerTests(testSize);
+        }},
+        {"unique_pointer_deleter", "UniquePointer with default, stateless, function pointer and pool deleters", [](int testSize, const std::vector<int> &) {
+            loadUniquePointerDeleterTests(testSize);
+        }},
+        {"unique_array", "Large-buffer allocation: MakeUniqueArray and ForOverwrite vs std::make_unique", [](int testSize, const std::vector<int> &) {
+            loadUniqueArrayTests(testSize);
+        }},
+        {"compact_pointer", "Compact 32-bit handle pointers vs UniquePointer and SharedPointer: build, random access, scan", [](int testSize, const std::vector<int> &) {
+            loadCompactPointerTests(testSize);
+        }},
+        {"tagged_pointer", "Memory footprint of flags packed into pointer bits vs stored beside the pointer", [](int testSize, const std::vector<int> &) {
+            loadTaggedPointerTests(testSize);
+        }},
+        {"shared_pointer", "SharedPointer in a vector", [](int testSize, const std::vector<int> &) {
+            loadSharedPointerTests(testSize);
+        }},
+        {"make_shared", "MakeShared vs std::make_shared", [](int testSize, const std::vector<int> &) {
+            loadMakeSharedPointerTests(testSize);
+        }},
+        {"shared_pointer_churn", "Reference count churn: vector push_back and list push/pop", [](int testSize, const std::vector<int> &) {
+            loadSharedPointerChurnTests(testSize);
+        }},
+        {"allocate_shared", "MakeShared vs AllocateShared and std::allocate_shared with a bump allocator, steady state", [](int testSize, const std::vector<int> &) {
+            loadAllocateSharedTests(testSize);
+        }},
+        {"weak_pointer_lock", "WeakPointer::lock on live objects", [](int testSize, const std::vector<int> &) {
+            loadWeakPointerLockTests(testSize);
+        }},
+        {"weak_pointer_release", "Releasing strong references while weak references remain", [](int testSize, const std::vector<int> &) {
+            loadWeakPointerReleaseTests(testSize);
+        }},
+        {"shared_pointer_deferred_release", "SharedPointer vector teardown with and without DeferredReleaseScope", [](int testSize, const std::vector<int> &) {
+            loadSharedPointerDeferredReleaseTests(testSize);
+        }},
+        {"shared_pointer_threads", "SharedPointer copies from several threads", [](int testSize, const std::vector<int> &threadCounts) {
+            loadSharedPointerThreadTests(testSize, threadCounts);
+        }},
+        {"biased_counting", "SharedPointer copies with biased vs atomic vs non-atomic counting", [](int testSize, const std::vector<int> &threadCounts) {
+            loadBiasedCountingTests(testSize, threadCounts);
+        }},
+        {"atomic_shared_pointer", "AtomicSharedPointer vs mutex-guarded SharedPointer vs std::atomic<std::shared_ptr>, reader-heavy", [](int testSize, const std::vector<int> &threadCounts) {
+            loadAtomicSharedPointerTests(testSize, threadCounts);
+        }},
+        {"linked_list_unique_pointer", "LinkedListUniquePointer", [](int testSize, const std::vector<int> &) {
+            loadLinkedListUniquePointerTests(testSize);
+        }},
+        {"linked_list_shared_pointer", "LinkedListSharedPointer", [](int testSize, const std::vector<int> &) {
+            loadLinkedListSharedPointerTests(testSize);
+        }},
+        {"linked_list_shared_pointer_allocations", "Allocations per LinkedListSharedPointer push_front and clear", [](int testSize, const std::vector<int> &) {
+            loadLinkedListSharedPointerAllocationTests(testSize);
+        }},
+        {"linked_list_pool_allocator", "Unique and shared pointer lists with malloc vs the pool allocator, RSS growth", [](int testSize, const std::vector<int> &) {
+            loadLinkedListPoolAllocatorTests(testSize);
+        }},
+        {"linked_list_teardown", "List construction and teardown, and a detached unique pointer chain", [](int testSize, const std::vector<int> &) {
+            loadLinkedListTeardownTests(testSize);
+        }},
+        {"linked_list_indexed", "LinkedListIndexed, nodes in contiguous arrays with index links", [](int testSize, const std::vector<int> &) {
+            loadLinkedListIndexedTests(testSize);
+        }},
+        {"linked_list_unrolled", "LinkedListUnrolled with 4, 16 and 64 elements per node", [](int testSize, const std::vector<int> &) {
+            loadLinkedListUnrolledTests(testSize);
+        }},
+        {"linked_list_traversal", "Sequential scan of the unique pointer, shared pointer, indexed and unrolled lists", [](int testSize, const std::vector<int> &) {
+            loadLinkedListTraversalTests(testSize);
+        }},
+        {"concurrent_stack", "Lock-free ConcurrentStack vs mutex-protected list from several threads", [](int testSize, const std::vector<int> &threadCounts) {
+            loadConcurrentStackTests(testSize, threadCounts);
+        }},
+        {"std_unique_ptr", "std::unique_ptr in a vector", [](int testSize, const std::vector<int> &) {
+            loadStdUniquePointerTests(testSize);
+        }},
+        {"std_shared_ptr", "std::shared_ptr in a vector", [](int testSize, const std::vector<int> &) {
+            loadStdSharedPointerTests(testSize);
+        }},
+        {"intrusive_pointer", "IntrusivePointer in a vector, non-atomic and atomic counts", [](int testSize, const std::vector<int> &) {
+            loadIntrusivePointerTests(testSize);
+        }},
+        {"linked_list_intrusive_pointer", "LinkedListIntrusivePointer", [](int testSize, const std::vector<int> &) {
+            loadLinkedListIntrusivePointerTests(testSize);
+        }},
+};
+
+static const char *defaultVariants[] = {
+        "unique_pointer", "shared_pointer", "linked_list_unique_pointer", "linked_list_shared_pointer",
+        "linked_list_indexed", "linked_list_unrolled", "linked_list_traversal", "std_unique_ptr", "std_shared_ptr",
+        "intrusive_pointer", "linked_list_intrusive_pointer"
+};
+
+struct CommandLineOptions {
+    std::vector<std::string> variants;
+    std::vector<int> sizes = {1000, 100'000, 10'000'000};
+    std::vector<int> threadCounts = defaultThreadCounts();
+    int warmups = -1;
+    int repetitions = -1;
+    std::string format;
+    std::string output;
+    bool perf = false;
+};
+
+static void printUsage(const char *program) {
+    std::string defaults;
+    for (const char *name : defaultVariants) {
+        defaults += defaults.empty() ? "" : ",";
+        defaults += name;
+    }
+
+    std::cout << "Usage:\n"
+              << "  " << program << "                      interactive menu\n"
+              << "  " << program << " [--benchmark] [options]\n"
+              << "  " << program << " --compare BASELINE CURRENT [--threshold PERCENT]\n"
+              << "  " << program << " --list\n\n"
+              << "Options:\n"
+              << "  --variants NAME[,NAME...]   variants to run, or \"all\" (default: " << defaults << ")\n"
+              << "  --sizes N[,N...]            element counts (default: 1000,100000,10000000)\n"
+              << "  --threads N[,N...]          thread counts for the threaded variants\n"
+              << "  --repetitions N             measured samples per benchmark\n"
+              << "  --warmups N                 warm-up iterations per benchmark\n"
+              << "  --format text|json|csv      record format (default: from --output, else text)\n"
+              << "  --output FILE               file for json/csv records\n"
+              << "  --perf                      also read hardware counters (cycles, instructions, cache and TLB misses)\n";
+}
+
+static void printVariants() {
+    for (const auto &variant : variants) {
+        std::cout << "  " << variant.name << " - " << variant.description << "\n";
+    }
+}
+
+static std::vector<std::string> splitList(const std::string &list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static std::vector<int> parsePositiveNumbers(const std::string &list, const std::string &option) {
+    std::vector<int> numbers;
+    for (const auto &item : splitList(list)) {
+        size_t parsed = 0;
+        int number = 0;
+        try {
+            number = std::stoi(item, &parsed);
+        } catch (const std::exception &) {
+            parsed = 0;
+        }
+        if (parsed != item.size() || number <= 0) {
+            throw std::invalid_argument("invalid value " + item + " for " + option);
+        }
+        numbers.push_back(number);
+    }
+    if (numbers.empty()) {
+        throw std::invalid_argument("empty list for " + option);
+    }
+    return numbers;
+}
+
+static const BenchmarkVariant &findVariant(const std::string &name) {
+    for (const auto &variant : variants) {
+        if (name == variant.name) {
+            return variant;
+        }
+    }
+    throw std::invalid_argument("unknown variant " + name + ", see --list");
+}
+
+static CommandLineOptions parseOptions(int argc, char *argv[]) {
+    CommandLineOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--benchmark") {
+            continue;
+        }
+        if (option == "--perf") {
+            options.perf = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("unknown option or missing value: " + option);
+        }
+        std::string value = argv[++i];
+
+        if (option == "--variants") {
+            options.variants = value == "all" ? std::vector<std::string>() : splitList(value);
+            if (value == "all") {
+                for (const auto &variant : variants) {
+                    options.variants.push_back(variant.name);
+                }
+            }
+        } else if (option == "--sizes") {
+            options.sizes = parsePositiveNumbers(value, option);
+        } else if (option == "--threads") {
+            options.threadCounts = parsePositiveNumbers(value, option);
+        } else if (option == "--repetitions") {
+            options.repetitions = parsePositiveNumbers(value, option).front();
+        } else if (option == "--warmups") {
+            options.warmups = std::stoi(value);
+        } else if (option == "--format") {
+            options.format = value;
+        } else if (option == "--output") {
+            options.output = value;
+        } else {
+            throw std::invalid_argument("unknown option " + option);
+        }
+    }
+
+    if (options.variants.empty()) {
+        options.variants.assign(std::begin(defaultVariants), std::end(defaultVariants));
+    }
+    if (options.format.empty()) {
+        bool csv = options.output.size() >= 4 && options.output.compare(options.output.size() - 4, 4, ".csv") == 0;
+        options.format = options.output.empty() ? "text" : csv ? "csv" : "json";
+    }
+    if (options.format != "text" && options.format != "json" && options.format != "csv") {
+        throw std::invalid_argument("unknown format " + options.format);
+    }
+    if (options.format != "text" && options.output.empty()) {
+        options.output = "benchmark_results." + options.format;
+    }
+
+    return options;
+}
+
+static int runBenchmarks(const CommandLineOptions &options) {
+    std::vector<const BenchmarkVariant *> selected;
+    for (const auto &name : options.variants) {
+        selected.push_back(&findVariant(name));
+    }
+    Benchmark::setRepetitions(options.warmups, options.repetitions);
+    enablePerfCounters(options.perf);
+
+    for (const auto *variant : selected) {
+        for (int testSize : options.sizes) {
+            std::cout << variant->name << ", size " << testSize << ": ";
+            variant->run(testSize, options.threadCounts);
+        }
+    }
+
+    if (options.format != "text") {
+        writeBenchmarkRecords(recordedBenchmarks(), options.output, options.format);
+        std::cout << "Wrote " << recordedBenchmarks().size() << " records to " << options.output << "\n";
+    }
+    return 0;
+}
+
+static int runCompare(int argc, char *argv[]) {
+    double threshold = 5;
+    for (int i = 4; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--threshold" && i + 1 < argc) {
+            threshold = std::stod(argv[++i]);
+        } else {
+            throw std::invalid_argument("unknown option " + option);
+        }
+    }
+
+    int regressions = compareBenchmarkRecords(readBenchmarkRecords(argv[2]), readBenchmarkRecords(argv[3]), threshold);
+    return regressions > 0 ? 1 : 0;
+}
+
+int runCommandLine(int argc, char *argv[]) {
+    std::string mode = argv[1];
+
+    if (mode == "--help" || mode == "-h") {
+        printUsage(argv[0]);
+        return 0;
+    }
+    if (mode == "--list") {
+        printVariants();
+        return 0;
+    }
+
+    try {
+        if (mode == "--compare") {
+            if (argc < 4) {
+                throw std::invalid_argument("--compare needs two result files");
+            }
+            return runCompare(argc, argv);
+        }
+        return runBenchmarks(parseOptions(argc, argv));
+    } catch (const std::invalid_argument &e) {
+        std::cout << "Error: " << e.what() << "\n\n";
+        printUsage(argv[0]);
+        return 2;
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+        return 2;
+    }
+}
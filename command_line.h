@@ -0,0 +1,3 @@
+#pragma once
+
+int runCommandLine(int argc, char *argv[]);
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Hands out slots from fixed-size chunks and names them by a 32-bit handle
+// instead of an address; handle 0 means null. Freed slots are reused through a
+// free list threaded through the slots themselves. Not thread-safe.
+template<typename Slot>
+class CompactArena {
+
+private:
+
+    static constexpr uint32_t chunkBits = 16;
+    static constexpr uint32_t chunkSlots = uint32_t(1) << chunkBits;
+    static constexpr uint32_t maxSlots = UINT32_MAX;
+
+    struct Cell {
+        alignas(Slot) alignas(uint32_t) unsigned char bytes[sizeof(Slot) > sizeof(uint32_t) ? sizeof(Slot) : sizeof(uint32_t)];
+    };
+
+    std::vector<Cell *> chunks;
+    uint32_t freeList;
+    uint32_t allocated;
+    size_t liveSlots;
+
+    Cell &cell(uint32_t handle) {
+        uint32_t index = handle - 1;
+        return chunks[index >> chunkBits][index & (chunkSlots - 1)];
+    }
+
+    uint32_t take() {
+        if (freeList) {
+            uint32_t handle = freeList;
+            freeList = *std::launder(reinterpret_cast<uint32_t *>(cell(handle).bytes));
+            return handle;
+        }
+        if (allocated == maxSlots) {
+            throw std::length_error("CompactArena: out of 32-bit handles");
+        }
+        if (allocated % chunkSlots == 0) {
+            chunks.push_back(new Cell[chunkSlots]);
+        }
+        return ++allocated;
+    }
+
+    void give(uint32_t handle) {
+        ::new(static_cast<void *>(cell(handle).bytes)) uint32_t(freeList);
+        freeList = handle;
+    }
+
+public:
+
+    CompactArena() : freeList(0), allocated(0), liveSlots(0) {}
+
+    CompactArena(const CompactArena &) = delete;
+    CompactArena &operator=(const CompactArena &) = delete;
+
+    ~CompactArena() {
+        for (Cell *chunk : chunks) {
+            delete[] chunk;
+        }
+    }
+
+    template<typename... Args>
+    uint32_t create(Args &&... args) {
+        uint32_t handle = take();
+        try {
+            ::new(static_cast<void *>(cell(handle).bytes)) Slot(std::forward<Args>(args)...);
+        } catch (...) {
+            give(handle);
+            throw;
+        }
+        ++liveSlots;
+        return handle;
+    }
+
+    void destroy(uint32_t handle) {
+        get(handle)->~Slot();
+        give(handle);
+        --liveSlots;
+    }
+
+    Slot *get(uint32_t handle) {
+        return std::launder(reinterpret_cast<Slot *>(cell(handle).bytes));
+    }
+
+    // Returns every chunk to the system once no slot is in use.
+    bool release() {
+        if (liveSlots != 0) {
+            return false;
+        }
+        for (Cell *chunk : chunks) {
+            delete[] chunk;
+        }
+        chunks.clear();
+        freeList = 0;
+        allocated = 0;
+        return true;
+    }
+
+    size_t chunkCount() const {
+        return chunks.size();
+    }
+};
+
+template<typename Slot>
+inline CompactArena<Slot> compactArenaInstance;
+
+
+// Owns one T in the arena for T; four bytes instead of a full pointer.
+template<typename T>
+class CompactUniquePointer {
+
+private:
+
+    uint32_t handle;
+
+    explicit CompactUniquePointer(uint32_t h) : handle(h) {}
+
+    void destroy() {
+        if (handle) {
+            arena().destroy(handle);
+        }
+    }
+
+    template<typename U, typename... Args>
+    friend CompactUniquePointer<U> MakeCompactUnique(Args &&... args);
+
+public:
+
+    static CompactArena<T> &arena() {
+        return compactArenaInstance<T>;
+    }
+
+    CompactUniquePointer() : handle(0) {}
+
+    ~CompactUniquePointer() {
+        destroy();
+    }
+
+    CompactUniquePointer(const CompactUniquePointer &) = delete;
+    CompactUniquePointer &operator=(const CompactUniquePointer &) = delete;
+
+    CompactUniquePointer(CompactUniquePointer &&other) noexcept : handle(other.handle) {
+        other.handle = 0;
+    }
+
+    CompactUniquePointer &operator=(CompactUniquePointer &&other) noexcept {
+        if (this != &other) {
+            destroy();
+            handle = other.handle;
+            other.handle = 0;
+        }
+        return *this;
+    }
+
+    T &operator*() const {
+        return *get();
+    }
+
+    T *operator->() const {
+        return get();
+    }
+
+    void reset() {
+        destroy();
+        handle = 0;
+    }
+
+    bool null() const {
+        return handle == 0;
+    }
+
+    T *get() const {
+        return handle ? arena().get(handle) : nullptr;
+    }
+};
+
+template<typename T, typename... Args>
+CompactUniquePointer<T> MakeCompactUnique(Args &&... args) {
+    return CompactUniquePointer<T>(CompactUniquePointer<T>::arena().create(std::forward<Args>(args)...));
+}
+
+
+// Value and its non-atomic reference count share one arena slot.
+template<typename T>
+struct CompactSharedSlot {
+
+    T value;
+    uint32_t referenceCount;
+
+    template<typename... Args>
+    explicit CompactSharedSlot(Args &&... args) : value(std::forward<Args>(args)...), referenceCount(1) {}
+};
+
+// Shares one T in the arena for CompactSharedSlot<T>; four bytes instead of two
+// pointers, and no separate control block.
+template<typename T>
+class CompactSharedPointer {
+
+private:
+
+    using Slot = CompactSharedSlot<T>;
+
+    uint32_t handle;
+
+    explicit CompactSharedPointer(uint32_t h) : handle(h) {}
+
+    void clean() {
+        if (handle && --arena().get(handle)->referenceCount == 0) {
+            arena().destroy(handle);
+        }
+    }
+
+    template<typename U, typename... Args>
+    friend CompactSharedPointer<U> MakeCompactShared(Args &&... args);
+
+public:
+
+    static CompactArena<Slot> &arena() {
+        return compactArenaInstance<Slot>;
+    }
+
+    CompactSharedPointer() : handle(0) {}
+
+    CompactSharedPointer(const CompactSharedPointer &other) : handle(other.handle) {
+        if (handle) {
+            ++arena().get(handle)->referenceCount;
+        }
+    }
+
+    CompactSharedPointer &operator=(const CompactSharedPointer &other) {
+        if (this != &other) {
+            if (other.handle) {
+                ++arena().get(other.handle)->referenceCount;
+            }
+            clean();
+            handle = other.handle;
+        }
+        return *this;
+    }
+
+    CompactSharedPointer(CompactSharedPointer &&other) noexcept : handle(other.handle) {
+        other.handle = 0;
+    }
+
+    CompactSharedPointer &operator=(CompactSharedPointer &&other) noexcept {
+        uint32_t h = other.handle;
+        other.handle = 0;
+        clean();
+        handle = h;
+        return *this;
+    }
+
+    ~CompactSharedPointer() {
+        clean();
+    }
+
+    T &operator*() const {
+        return *get();
+    }
+
+    T *operator->() const {
+        return get();
+    }
+
+    size_t use_count() const {
+        return handle ? arena().get(handle)->referenceCount : 0;
+    }
+
+    void reset() {
+        clean();
+        handle = 0;
+    }
+
+    bool null() const {
+        return handle == 0;
+    }
+
+    T *get() const {
+        return handle ? &arena().get(handle)->value : nullptr;
+    }
+};
+
+template<typename T, typename... Args>
+CompactSharedPointer<T> MakeCompactShared(Args &&... args) {
+    return CompactSharedPointer<T>(CompactSharedPointer<T>::arena().create(std::forward<Args>(args)...));
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Safe memory reclamation for lock-free structures. Before dereferencing a
+// shared node a thread publishes its address in its own hazard slot; a node
+// unlinked from the structure is retired and only destroyed once no slot holds
+// it. One slot per thread is enough for a stack, where a thread only ever
+// protects the head it is popping. Slots come in blocks of 128; when every
+// slot is taken another block is appended, and blocks live until exit.
+class HazardPointers {
+
+private:
+
+    struct alignas(64) Slot {
+        std::atomic<const void *> pointer{nullptr};
+        std::atomic<bool> owned{false};
+    };
+
+    struct Retired {
+        void *pointer;
+        void (*destroy)(void *);
+    };
+
+    // Nodes left behind by exited threads because another thread still protected them.
+    struct OrphanList {
+
+        std::mutex mutex;
+        std::vector<Retired> nodes;
+        std::atomic<bool> pending{false};
+
+        ~OrphanList() {
+            for (const Retired &node : nodes) {
+                node.destroy(node.pointer);
+            }
+        }
+    };
+
+    static constexpr size_t slotsPerBlock = 128;
+
+    struct SlotBlock {
+
+        Slot slots[slotsPerBlock];
+        std::atomic<SlotBlock *> next{nullptr};
+
+        ~SlotBlock() {
+            delete next.load(std::memory_order_acquire);
+        }
+    };
+
+    static SlotBlock firstBlock;
+    static std::atomic<size_t> slotCount;
+    static OrphanList orphans;
+
+    static Slot *claimSlot() {
+        SlotBlock *block = &firstBlock;
+        while (true) {
+            for (Slot &slot : block->slots) {
+                bool expected = false;
+                if (!slot.owned.load(std::memory_order_relaxed) &&
+                    slot.owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return &slot;
+                }
+            }
+
+            SlotBlock *next = block->next.load(std::memory_order_acquire);
+            if (!next) {
+                SlotBlock *grown = new SlotBlock();
+                if (block->next.compare_exchange_strong(next, grown, std::memory_order_acq_rel)) {
+                    slotCount.fetch_add(slotsPerBlock, std::memory_order_relaxed);
+                    next = grown;
+                } else {
+                    delete grown;
+                }
+            }
+            block = next;
+        }
+    }
+
+    // Destroys every retired node that no thread currently protects.
+    static void scan(std::vector<Retired> &retired) {
+        std::vector<const void *> hazards;
+        for (SlotBlock *block = &firstBlock; block; block = block->next.load(std::memory_order_acquire)) {
+            for (const Slot &slot : block->slots) {
+                if (const void *pointer = slot.pointer.load(std::memory_order_seq_cst)) {
+                    hazards.push_back(pointer);
+                }
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        size_t kept = 0;
+        for (const Retired &node : retired) {
+            if (std::binary_search(hazards.begin(), hazards.end(), node.pointer)) {
+                retired[kept++] = node;
+            } else {
+                node.destroy(node.pointer);
+            }
+        }
+        retired.resize(kept);
+    }
+
+    struct ThreadRecord {
+
+        Slot *slot;
+        std::vector<Retired> retired;
+
+        ThreadRecord() : slot(claimSlot()) {}
+
+        ~ThreadRecord() {
+            slot->pointer.store(nullptr, std::memory_order_release);
+            scan(retired);
+            if (!retired.empty()) {
+                std::lock_guard<std::mutex> lock(orphans.mutex);
+                orphans.nodes.insert(orphans.nodes.end(), retired.begin(), retired.end());
+                orphans.pending.store(true, std::memory_order_release);
+            }
+            slot->owned.store(false, std::memory_order_release);
+        }
+    };
+
+    static ThreadRecord &record() {
+        thread_local ThreadRecord threadRecord;
+        return threadRecord;
+    }
+
+public:
+
+    // The caller must re-read the shared location afterwards and only use the
+    // pointer if it is still there; the sequentially consistent store orders
+    // the publication before that re-read.
+    static void protect(const void *pointer) {
+        record().slot->pointer.store(pointer, std::memory_order_seq_cst);
+    }
+
+    static void clear() {
+        record().slot->pointer.store(nullptr, std::memory_order_release);
+    }
+
+    template<typename T>
+    static void retire(T *pointer) {
+        ThreadRecord &threadRecord = record();
+        threadRecord.retired.push_back({pointer, [](void *p) {
+            delete static_cast<T *>(p);
+        }});
+        // Scanning once twice as many nodes are retired as there are slots keeps
+        // the cost per retired node constant.
+        if (threadRecord.retired.size() >= 2 * slotCount.load(std::memory_order_relaxed)) {
+            if (orphans.pending.load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> lock(orphans.mutex);
+                threadRecord.retired.insert(threadRecord.retired.end(), orphans.nodes.begin(), orphans.nodes.end());
+                orphans.nodes.clear();
+                orphans.pending.store(false, std::memory_order_relaxed);
+            }
+            scan(threadRecord.retired);
+        }
+    }
+};
+
+inline HazardPointers::SlotBlock HazardPointers::firstBlock;
+inline std::atomic<size_t> HazardPointers::slotCount{HazardPointers::slotsPerBlock};
+inline HazardPointers::OrphanList HazardPointers::orphans;
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "reference_counting.h"
+
+// IntrusivePointer<T> works with any T for which argument-dependent lookup finds
+// intrusiveRetain(T*) and intrusiveRelease(T*); the release hook destroys the
+// object once the last reference is gone.
+
+// CRTP base keeping the count inside the object itself. The last release
+// deletes through Derived, so if objects of classes derived from Derived are
+// counted too, Derived needs a virtual destructor.
+template<typename Derived, typename Counting = NonAtomicCounting>
+class IntrusiveCounted {
+
+private:
+
+    mutable typename Counting::Counter referenceCount;
+
+    friend void intrusiveRetain(const IntrusiveCounted *object) {
+        Counting::increment(object->referenceCount);
+    }
+
+    friend void intrusiveRelease(const IntrusiveCounted *object) {
+        if (Counting::decrement(object->referenceCount)) {
+            delete static_cast<const Derived *>(object);
+        }
+    }
+
+protected:
+
+    IntrusiveCounted() : referenceCount(0) {}
+
+    // A copy is a new object with no owners yet.
+    IntrusiveCounted(const IntrusiveCounted &) : referenceCount(0) {}
+
+    IntrusiveCounted &operator=(const IntrusiveCounted &) {
+        return *this;
+    }
+
+    ~IntrusiveCounted() = default;
+
+public:
+
+    size_t use_count() const {
+        return Counting::load(referenceCount);
+    }
+};
+
+
+template<typename T>
+class IntrusivePointer {
+
+private:
+
+    T* pointer;
+
+    void clean() {
+        if (pointer) {
+            intrusiveRelease(pointer);
+        }
+    }
+
+    template<typename U>
+    friend class IntrusivePointer;
+
+public:
+
+    explicit IntrusivePointer(T* p = nullptr) : pointer(p) {
+        if (pointer) {
+            intrusiveRetain(pointer);
+        }
+    }
+
+    IntrusivePointer(const IntrusivePointer& other) : pointer(other.pointer) {
+        if (pointer) {
+            intrusiveRetain(pointer);
+        }
+    }
+
+    IntrusivePointer& operator=(const IntrusivePointer& other) {
+        if (this != &other) {
+            if (other.pointer) {
+                intrusiveRetain(other.pointer);
+            }
+            clean();
+            pointer = other.pointer;
+        }
+        return *this;
+    }
+
+    IntrusivePointer(IntrusivePointer&& other) noexcept : pointer(other.pointer) {
+        other.pointer = nullptr;
+    }
+
+    IntrusivePointer& operator=(IntrusivePointer&& other) noexcept {
+        T* p = other.pointer;
+        other.pointer = nullptr;
+        clean();
+        pointer = p;
+        return *this;
+    }
+
+    template<typename U>
+    IntrusivePointer(const IntrusivePointer<U>& other)
+    requires std::is_convertible_v<U*, T*>
+            : pointer(other.pointer) {
+        if (pointer) {
+            intrusiveRetain(pointer);
+        }
+    }
+
+    template<typename U>
+    IntrusivePointer(IntrusivePointer<U>&& other) noexcept
+    requires std::is_convertible_v<U*, T*>
+            : pointer(other.pointer) {
+        other.pointer = nullptr;
+    }
+
+    template<typename U>
+    IntrusivePointer& operator=(IntrusivePointer<U>&& other) noexcept
+    requires std::is_convertible_v<U*, T*> {
+        T* p = other.pointer;
+        other.pointer = nullptr;
+        clean();
+        pointer = p;
+        return *this;
+    }
+
+    ~IntrusivePointer() {
+        clean();
+    }
+
+    T* get() const {
+        return pointer;
+    }
+
+    T& operator*() const {
+        return *pointer;
+    }
+
+    T* operator->() const {
+        return pointer;
+    }
+
+    size_t use_count() const {
+        return pointer ? pointer->use_count() : 0;
+    }
+
+    void reset(T* p = nullptr) {
+        if (p) {
+            intrusiveRetain(p);
+        }
+        clean();
+        pointer = p;
+    }
+
+    bool null() const {
+        return pointer == nullptr;
+    }
+};
+
+template<typename T, typename... Args>
+IntrusivePointer<T> MakeIntrusive(Args&&... args) {
+    return IntrusivePointer<T>(new T(std::forward<Args>(args)...));
+}
@@ -1,27 +1,312 @@
 #include "load_tests.h"
+#include "allocation_counter.h"
+#include "atomic_shared_pointer.h"
+#include "compact_pointer.h"
+#include "intrusive_pointer.h"
+#include "benchmark.h"
+#include "benchmark_report.h"
+#include "memory_usage.h"
 #include "shared_pointer.h"
+#include "tagged_pointer.h"
 #include "unique_pointer.h"
+#include "pool_allocator.h"
+#include "weak_pointer.h"
 //#include "progress_bar.h"
 #include "test_structure.h"
 
-#include <chrono>
 #include <iostream>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+template<typename Pointer, typename Factory, typename Churn>
+void measurePointerVectorPhases(BenchmarkSample &sample, int testSize, Factory factory, Churn churn) {
+    std::vector<Pointer> pointers;
+
+    sample.measure("construction", testSize, [&]() {
+        for (int i = 0; i < testSize; ++i) {
+            pointers.push_back(factory(i));
+        }
+    });
+    sample.measure("traversal", testSize, [&]() {
+        long long sum = 0;
+        for (const auto &pointer : pointers) {
+            sum += *pointer;
+        }
+        doNotOptimize(sum);
+    });
+    sample.measure("churn", testSize, [&]() {
+        churn(pointers);
+    });
+    sample.measure("destruction", testSize, [&]() {
+        std::vector<Pointer>().swap(pointers);
+    });
+}
+
+template<typename Pointer, typename Factory, typename Churn>
+void runPointerVectorBenchmark(const char *variant, int testSize, Factory factory, Churn churn) {
+    Benchmark benchmark = Benchmark::forSize(testSize);
+    benchmark.run([&](BenchmarkSample &sample) {
+        measurePointerVectorPhases<Pointer>(sample, testSize, factory, churn);
+    });
+    printPhaseStatistics(benchmark.statistics());
+    recordBenchmark(variant, testSize, benchmark.statistics());
+}
+
+template<typename Pointer>
+void movePointers(std::vector<Pointer> &pointers) {
+    std::vector<Pointer> moved;
+    moved.reserve(pointers.size());
+    for (auto &pointer : pointers) {
+        moved.push_back(std::move(pointer));
+    }
+    pointers.swap(moved);
+}
+
+template<typename Pointer>
+void copyPointers(std::vector<Pointer> &pointers) {
+    std::vector<Pointer> copies(pointers);
+}
+
+template<typename List>
+void measureLinkedListPhases(BenchmarkSample &sample, int testSize) {
+    List list;
+
+    sample.measure("construction", testSize, [&]() {
+        for (int i = 0; i < testSize; ++i) {
+            list.push_front(i);
+        }
+    });
+    sample.measure("traversal", testSize, [&]() {
+        long long sum = 0;
+        list.for_each([&sum](int value) {
+            sum += value;
+        });
+        doNotOptimize(sum);
+    });
+    sample.measure("churn", testSize, [&]() {
+        for (int i = 0; i < testSize; ++i) {
+            list.pop_front();
+            list.push_front(i);
+        }
+    });
+    sample.measure("destruction", testSize, [&]() {
+        list.clear();
+    });
+}
+
+template<typename List>
+void runLinkedListBenchmark(const char *variant, int testSize) {
+    Benchmark benchmark = Benchmark::forSize(testSize);
+    benchmark.run([&](BenchmarkSample &sample) {
+        measureLinkedListPhases<List>(sample, testSize);
+    });
+    printPhaseStatistics(benchmark.statistics());
+    recordBenchmark(variant, testSize, benchmark.statistics());
+}
 
 void loadUniquePointerTests(int testSize){
     try {
-        auto start = std::chrono::high_resolution_clock::now();
-        std::vector<UniquePointer<int>> pointers;
+        runPointerVectorBenchmark<UniquePointer<int>>("unique_pointer", testSize, [](int i) {
+            return UniquePointer<int>(new int(i));
+        }, movePointers<UniquePointer<int>>);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
 
+template<typename Pointer, typename Factory>
+void measureCompactPointerPhases(BenchmarkSample &sample, int testSize, const std::vector<int> &randomOrder,
+                                 Factory factory) {
+    std::vector<Pointer> pointers;
+
+    sample.measure("construction", testSize, [&]() {
+        pointers.reserve(testSize);
         for (int i = 0; i < testSize; ++i) {
-            pointers.push_back(UniquePointer<int>(new int(i)));
+            pointers.push_back(factory(i));
+        }
+    });
+    sample.measure("random_access", testSize, [&]() {
+        long long sum = 0;
+        for (int index : randomOrder) {
+            sum += *pointers[index];
+        }
+        doNotOptimize(sum);
+    });
+    sample.measure("traversal", testSize, [&]() {
+        long long sum = 0;
+        for (const auto &pointer : pointers) {
+            sum += *pointer;
+        }
+        doNotOptimize(sum);
+    });
+    sample.measure("destruction", testSize, [&]() {
+        std::vector<Pointer>().swap(pointers);
+    });
+}
+
+template<typename Pointer, typename Factory>
+void runCompactPointerBenchmark(const char *name, const char *variant, int testSize,
+                                const std::vector<int> &randomOrder, Factory factory) {
+    Benchmark benchmark = Benchmark::forSize(testSize);
+    benchmark.run([&](BenchmarkSample &sample) {
+        measureCompactPointerPhases<Pointer>(sample, testSize, randomOrder, factory);
+    });
+    std::cout << "    " << name << " (" << sizeof(Pointer) << " B per element):";
+    printPhaseStatistics(benchmark.statistics());
+    recordBenchmark(variant, testSize, benchmark.statistics());
+}
 
-            /*if (i % (testSize / 100) == 0) {
-                printProgressBar(i + 1, testSize);
-            }*/
+void loadCompactPointerTests(int testSize){
+    try {
+        std::vector<int> randomOrder(testSize);
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> distribution(0, testSize - 1);
+        for (int &index : randomOrder) {
+            index = distribution(generator);
         }
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-        std::cout << "Time: " << duration << " ms\n";
+
+        std::cout << "\n";
+        runCompactPointerBenchmark<UniquePointer<int>>("UniquePointer", "unique_pointer_access", testSize, randomOrder,
+                                                       [](int i) {
+            return UniquePointer<int>(new int(i));
+        });
+        runCompactPointerBenchmark<CompactUniquePointer<int>>("CompactUniquePointer", "compact_unique_pointer", testSize,
+                                                              randomOrder, [](int i) {
+            return MakeCompactUnique<int>(i);
+        });
+        CompactUniquePointer<int>::arena().release();
+        runCompactPointerBenchmark<SharedPointer<int>>("SharedPointer", "shared_pointer_access", testSize, randomOrder,
+                                                       [](int i) {
+            return MakeShared<int>(i);
+        });
+        runCompactPointerBenchmark<CompactSharedPointer<int>>("CompactSharedPointer", "compact_shared_pointer", testSize,
+                                                              randomOrder, [](int i) {
+            return MakeCompactShared<int>(i);
+        });
+        CompactSharedPointer<int>::arena().release();
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+template<typename Array, typename Make>
+void measureUniqueArray(const char *name, const char *variant, int testSize, Make make) {
+    Benchmark benchmark = Benchmark::forSize(testSize);
+    benchmark.run([&](BenchmarkSample &sample) {
+        Array array;
+
+        sample.measure("allocation", testSize, [&]() {
+            array = make(testSize);
+        });
+        sample.measure("first_write", testSize, [&]() {
+            for (int i = 0; i < testSize; ++i) {
+                array[i] = i;
+            }
+            doNotOptimize(array[testSize - 1]);
+        });
+        sample.measure("release", testSize, [&]() {
+            array.reset();
+        });
+    });
+    std::cout << "    " << name << ":";
+    printPhaseStatistics(benchmark.statistics());
+    recordBenchmark(variant, testSize, benchmark.statistics());
+}
+
+void loadUniqueArrayTests(int testSize){
+    try {
+        std::cout << "\n";
+        measureUniqueArray<std::unique_ptr<int[]>>("std::make_unique", "std_make_unique_array", testSize, [](int n) {
+            return std::make_unique<int[]>(n);
+        });
+        measureUniqueArray<std::unique_ptr<int[]>>("std::make_unique_for_overwrite", "std_make_unique_for_overwrite",
+                                                   testSize, [](int n) {
+            return std::make_unique_for_overwrite<int[]>(n);
+        });
+        measureUniqueArray<UniqueArray<int>>("MakeUniqueArray", "make_unique_array", testSize, [](int n) {
+            return MakeUniqueArray<int>(n);
+        });
+        measureUniqueArray<UniqueArray<int>>("MakeUniqueArrayForOverwrite", "make_unique_array_for_overwrite", testSize,
+                                             [](int n) {
+            return MakeUniqueArrayForOverwrite<int>(n);
+        });
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+struct NoReset {
+
+    void operator()() const {}
+};
+
+// Builds a vector of testSize pointers, then clears it; reset runs before every
+// sample, outside the timed phases.
+template<typename Pointer, typename Factory, typename Reset = NoReset>
+void runPointerBuildBenchmark(const char *name, const char *variant, int testSize, Factory factory,
+                              Reset reset = Reset()) {
+    Benchmark benchmark = Benchmark::forSize(testSize);
+    benchmark.run([&](BenchmarkSample &sample) {
+        std::vector<Pointer> pointers;
+        pointers.reserve(testSize);
+        reset();
+
+        sample.measure("construction", testSize, [&]() {
+            for (int i = 0; i < testSize; ++i) {
+                pointers.push_back(factory(i));
+            }
+        });
+        sample.measure("destruction", testSize, [&]() {
+            pointers.clear();
+        });
+    });
+    std::cout << "    " << name << " (" << sizeof(Pointer) << " B):";
+    printPhaseStatistics(benchmark.statistics());
+    recordBenchmark(variant, testSize, benchmark.statistics());
+}
+
+struct PlainDelete {
+
+    void operator()(int *p) const {
+        delete p;
+    }
+};
+
+void deleteInt(int *p) {
+    delete p;
+}
+
+void loadUniquePointerDeleterTests(int testSize){
+    try {
+        using FunctionDeleter = void (*)(int *);
+
+        std::cout << "\n";
+        runPointerBuildBenchmark<UniquePointer<int>>("Default", "unique_pointer_default_delete", testSize, [](int i) {
+            return UniquePointer<int>(new int(i));
+        });
+        runPointerBuildBenchmark<UniquePointer<int, PlainDelete>>("Stateless", "unique_pointer_stateless_delete",
+                                                                  testSize, [](int i) {
+            return UniquePointer<int, PlainDelete>(new int(i));
+        });
+        runPointerBuildBenchmark<UniquePointer<int, FunctionDeleter>>("Function pointer", "unique_pointer_function_delete",
+                                                                      testSize, [](int i) {
+            return UniquePointer<int, FunctionDeleter>(new int(i), deleteInt);
+        });
+        runPointerBuildBenchmark<UniquePointer<int, PoolDelete<int>>>("Pool", "unique_pointer_pool_delete", testSize,
+                                                                      [](int i) {
+            return UniquePointer<int, PoolDelete<int>>(new(PoolAllocator::allocate<int>()) int(i));
+        });
+        PoolAllocator::release<int>();
     } catch (const std::exception &e) {
         std::cout << "Failed with exception: " << e.what() << "\n";
     } catch (...) {
@@ -31,20 +316,185 @@ void loadUniquePointerTests(int testSize){
 
 void loadSharedPointerTests(int testSize){
     try {
-        auto start = std::chrono::high_resolution_clock::now();
-        std::vector<SharedPointer<int>> pointers;
+        runPointerVectorBenchmark<SharedPointer<int>>("shared_pointer", testSize, [](int i) {
+            return SharedPointer<int>(new int(i));
+        }, copyPointers<SharedPointer<int>>);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
 
-        for (int i = 0; i < testSize; ++i) {
-            int *p = new int(i);
-            pointers.push_back(SharedPointer<int>(p));
+// Builds a fresh vector per phase so every phase tears down the same workload.
+// DeferredCounting pointers are torn down inside a DeferredReleaseScope.
+template<typename Pointer, typename Shuffle>
+void measureSharedPointerTeardown(BenchmarkSample &sample, const char *phase, int testSize, Shuffle shuffle) {
+    std::vector<Pointer> pointers;
+    pointers.reserve(testSize);
+    for (int i = 0; i < testSize; ++i) {
+        pointers.push_back(Pointer(new int(i)));
+    }
+    shuffle(pointers);
+
+    sample.measure(phase, testSize, [&]() {
+        DeferredReleaseScope scope;
+        std::vector<Pointer>().swap(pointers);
+    });
+}
+
+void loadSharedPointerDeferredReleaseTests(int testSize){
+    try {
+        using DeferredPointer = SharedPointer<int, DeferredCounting<NonAtomicCounting>>;
+        auto inOrder = [](auto &) {};
+        auto shuffled = [](auto &pointers) {
+            std::mt19937 generator(42);
+            std::shuffle(pointers.begin(), pointers.end(), generator);
+        };
+
+        Benchmark benchmark = Benchmark::forSize(testSize);
+        benchmark.run([&](BenchmarkSample &sample) {
+            measureSharedPointerTeardown<SharedPointer<int>>(sample, "destruction", testSize, inOrder);
+            measureSharedPointerTeardown<DeferredPointer>(sample, "deferred_destruction", testSize, inOrder);
+            measureSharedPointerTeardown<SharedPointer<int>>(sample, "shuffled_destruction", testSize, shuffled);
+            measureSharedPointerTeardown<DeferredPointer>(sample, "shuffled_deferred_destruction", testSize,
+                                                          shuffled);
+        });
+        printPhaseStatistics(benchmark.statistics());
+        recordBenchmark("shared_pointer_deferred_release", testSize, benchmark.statistics());
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+void loadMakeSharedPointerTests(int testSize){
+    try {
+        std::cout << "\n";
+        runPointerBuildBenchmark<SharedPointer<int>>("MakeShared", "make_shared", testSize, [](int i) {
+            return MakeShared<int>(i);
+        });
+        runPointerBuildBenchmark<std::shared_ptr<int>>("std::make_shared", "std_make_shared", testSize, [](int i) {
+            return std::make_shared<int>(i);
+        });
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+// Times the two reference-count-heavy workloads; with SHARED_POINTER_STATISTICS
+// also reports how many count updates each operation made.
+void loadSharedPointerChurnTests(int testSize){
+    try {
+        Benchmark benchmark = Benchmark::forSize(testSize);
+        double updates[4] = {};
+        benchmark.run([&](BenchmarkSample &sample) {
+#ifdef SHARED_POINTER_STATISTICS
+            SharedPointerStatistics::reset();
+#endif
+            sample.measure("vector_push_back", testSize, [&]() {
+                std::vector<SharedPointer<int>> pointers;
+
+                for (int i = 0; i < testSize; ++i) {
+                    pointers.push_back(SharedPointer<int>(new int(i)));
+                }
+            });
+#ifdef SHARED_POINTER_STATISTICS
+            updates[0] = double(SharedPointerStatistics::increments) / testSize;
+            updates[1] = double(SharedPointerStatistics::decrements) / testSize;
+            SharedPointerStatistics::reset();
+#endif
+            sample.measure("list_push_pop", testSize, [&]() {
+                LinkedListSharedPointer<int> list;
+
+                for (int i = 0; i < testSize; ++i) {
+                    list.push_front(i);
+                }
+                while (!list.null()) {
+                    list.pop_front();
+                }
+            });
+#ifdef SHARED_POINTER_STATISTICS
+            updates[2] = double(SharedPointerStatistics::increments) / testSize;
+            updates[3] = double(SharedPointerStatistics::decrements) / testSize;
+#endif
+        });
+        printPhaseStatistics(benchmark.statistics());
+        recordBenchmark("shared_pointer_churn", testSize, benchmark.statistics());
+#ifdef SHARED_POINTER_STATISTICS
+        std::cout << "    Vector push_back: " << updates[0] << " inc/op, " << updates[1] << " dec/op; "
+                  << "list push/pop: " << updates[2] << " inc/op, " << updates[3] << " dec/op\n";
+#else
+        (void)updates;
+#endif
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
 
-            /*if (i % (testSize / 100) == 0) {
-                printProgressBar(i + 1, testSize);
-            }*/
+template<typename Counting>
+void runSharedPointerCopies(int threadCount, int testSize, bool sharedObject) {
+    SharedPointer<int, Counting> source = MakeShared<int, Counting>(1);
+    std::vector<std::thread> threads;
+    int copiesPerThread = testSize / threadCount;
+
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&]() {
+            SharedPointer<int, Counting> local = sharedObject ? source : MakeShared<int, Counting>(1);
+            long long sum = 0;
+
+            for (int i = 0; i < copiesPerThread; ++i) {
+                SharedPointer<int, Counting> copy(local);
+                doNotOptimize(copy);
+                sum += *copy;
+            }
+            doNotOptimize(sum);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+std::vector<int> defaultThreadCounts() {
+    std::vector<int> threadCounts;
+    int maxThreads = std::max(2, int(std::thread::hardware_concurrency()));
+    for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        threadCounts.push_back(threadCount);
+    }
+    return threadCounts;
+}
+
+void loadSharedPointerThreadTests(int testSize){
+    loadSharedPointerThreadTests(testSize, defaultThreadCounts());
+}
+
+void loadSharedPointerThreadTests(int testSize, const std::vector<int> &threadCounts){
+    try {
+        std::cout << "\n";
+        for (int threadCount : threadCounts) {
+            Benchmark benchmark = Benchmark::forSize(testSize);
+            benchmark.run([&](BenchmarkSample &sample) {
+                sample.measure("non_atomic_private_object", testSize, [&]() {
+                    runSharedPointerCopies<NonAtomicCounting>(threadCount, testSize, false);
+                });
+                sample.measure("atomic_private_object", testSize, [&]() {
+                    runSharedPointerCopies<AtomicCounting>(threadCount, testSize, false);
+                });
+                sample.measure("atomic_shared_object", testSize, [&]() {
+                    runSharedPointerCopies<AtomicCounting>(threadCount, testSize, true);
+                });
+            });
+
+            std::cout << "    Threads: " << threadCount;
+            printPhaseStatistics(benchmark.statistics());
+            recordBenchmark("shared_pointer_threads", testSize, benchmark.statistics(), threadCount);
         }
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-        std::cout << "Time: " << duration << " ms\n";
     } catch (const std::exception &e) {
         std::cout << "Failed with exception: " << e.what() << "\n";
     } catch (...) {
@@ -52,21 +502,62 @@ void loadSharedPointerTests(int testSize){
     }
 }
 
-void loadLinkedListUniquePointerTests(int testSize){
+// Each thread copies an object it created itself, and every remoteEvery-th copy
+// is of an object the calling thread created instead (none if remoteEvery is 0).
+template<typename Counting>
+void runMixedCopies(int threadCount, int testSize, int remoteEvery) {
+    SharedPointer<int, Counting> remote = MakeShared<int, Counting>(1);
+    std::vector<std::thread> threads;
+    int copiesPerThread = testSize / threadCount;
+
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&]() {
+            SharedPointer<int, Counting> local = MakeShared<int, Counting>(1);
+            long long sum = 0;
+
+            for (int i = 0; i < copiesPerThread; ++i) {
+                SharedPointer<int, Counting> copy(remoteEvery && i % remoteEvery == 0 ? remote : local);
+                doNotOptimize(copy);
+                sum += *copy;
+            }
+            doNotOptimize(sum);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void loadBiasedCountingTests(int testSize){
+    loadBiasedCountingTests(testSize, defaultThreadCounts());
+}
+
+void loadBiasedCountingTests(int testSize, const std::vector<int> &threadCounts){
     try {
-        auto start = std::chrono::high_resolution_clock::now();
-        LinkedListUniquePointer<int> list;
+        const int remoteEvery = 10;
 
-        for (int i = 0; i < testSize; ++i) {
-            list.push_front(i);
+        std::cout << "\n";
+        for (int threadCount : threadCounts) {
+            Benchmark benchmark = Benchmark::forSize(testSize);
+            benchmark.run([&](BenchmarkSample &sample) {
+                sample.measure("non_atomic_local_only", testSize, [&]() {
+                    runMixedCopies<NonAtomicCounting>(threadCount, testSize, 0);
+                });
+                sample.measure("atomic_mixed", testSize, [&]() {
+                    runMixedCopies<AtomicCounting>(threadCount, testSize, remoteEvery);
+                });
+                sample.measure("biased_mixed", testSize, [&]() {
+                    runMixedCopies<BiasedCounting>(threadCount, testSize, remoteEvery);
+                });
+                sample.measure("biased_local_only", testSize, [&]() {
+                    runMixedCopies<BiasedCounting>(threadCount, testSize, 0);
+                });
+            });
 
-            /*if (i % (testSize / 100) == 0) {
-                printProgressBar(i + 1, testSize);
-            }*/
+            std::cout << "    Threads: " << threadCount;
+            printPhaseStatistics(benchmark.statistics());
+            recordBenchmark("biased_counting", testSize, benchmark.statistics(), threadCount);
         }
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-        std::cout << "Time: " << duration << " ms, Size: " << list.size() << "\n";
     } catch (const std::exception &e) {
         std::cout << "Failed with exception: " << e.what() << "\n";
     } catch (...) {
@@ -74,21 +565,88 @@ void loadLinkedListUniquePointerTests(int testSize){
     }
 }
 
-void loadLinkedListSharedPointerTests(int testSize){
+struct Configuration {
+    long long version;
+    long long values[7];
+};
+
+// Thread 0 publishes a new snapshot every 64th operation, every other operation
+// on every thread reads the current one.
+template<typename Load, typename Store>
+void runSnapshotPublication(int threadCount, int testSize, Load load, Store store) {
+    std::vector<std::thread> threads;
+    int operationsPerThread = testSize / threadCount;
+
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            long long sum = 0;
+
+            for (int i = 0; i < operationsPerThread; ++i) {
+                if (t == 0 && i % 64 == 0) {
+                    store(i);
+                } else {
+                    sum += load();
+                }
+            }
+            doNotOptimize(sum);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void loadAtomicSharedPointerTests(int testSize){
+    loadAtomicSharedPointerTests(testSize, defaultThreadCounts());
+}
+
+void loadAtomicSharedPointerTests(int testSize, const std::vector<int> &threadCounts){
     try {
-        auto start = std::chrono::high_resolution_clock::now();
-        LinkedListSharedPointer<int> list;
+        using ConfigurationPointer = SharedPointer<Configuration, AtomicCounting>;
 
-        for (int i = 0; i < testSize; ++i) {
-            list.push_front(i);
+        std::cout << "\n";
+        for (int threadCount : threadCounts) {
+            AtomicSharedPointer<Configuration> atomicSlot(MakeShared<Configuration, AtomicCounting>());
+            std::mutex mutex;
+            ConfigurationPointer guardedSlot = MakeShared<Configuration, AtomicCounting>();
+            std::atomic<std::shared_ptr<Configuration>> stdSlot(std::make_shared<Configuration>());
+
+            Benchmark benchmark = Benchmark::forSize(testSize);
+            benchmark.run([&](BenchmarkSample &sample) {
+                sample.measure("atomic_shared_pointer", testSize, [&]() {
+                    runSnapshotPublication(threadCount, testSize, [&]() {
+                        return atomicSlot.load()->version;
+                    }, [&](int i) {
+                        atomicSlot.store(MakeShared<Configuration, AtomicCounting>(Configuration{i, {}}));
+                    });
+                });
+                sample.measure("mutex_shared_pointer", testSize, [&]() {
+                    runSnapshotPublication(threadCount, testSize, [&]() {
+                        ConfigurationPointer snapshot;
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            snapshot = guardedSlot;
+                        }
+                        return snapshot->version;
+                    }, [&](int i) {
+                        ConfigurationPointer replacement = MakeShared<Configuration, AtomicCounting>(Configuration{i, {}});
+                        std::lock_guard<std::mutex> lock(mutex);
+                        guardedSlot = std::move(replacement);
+                    });
+                });
+                sample.measure("std_atomic_shared_ptr", testSize, [&]() {
+                    runSnapshotPublication(threadCount, testSize, [&]() {
+                        return stdSlot.load()->version;
+                    }, [&](int i) {
+                        stdSlot.store(std::make_shared<Configuration>(Configuration{i, {}}));
+                    });
+                });
+            });
 
-            /*if (i % (testSize / 100) == 0) {
-                printProgressBar(i + 1, testSize);
-            }*/
+            std::cout << "    Threads: " << threadCount;
+            printPhaseStatistics(benchmark.statistics());
+            recordBenchmark("atomic_shared_pointer", testSize, benchmark.statistics(), threadCount);
         }
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-        std::cout << "Time: " << duration << " ms, Size: " << list.size() << "\n";
     } catch (const std::exception &e) {
         std::cout << "Failed with exception: " << e.what() << "\n";
     } catch (...) {
@@ -96,21 +654,217 @@ void loadLinkedListSharedPointerTests(int testSize){
     }
 }
 
-void loadStdUniquePointerTests(int testSize){
+// The warm-up sample grows the vector and the arena, so the measured samples
+// see the steady state of a second round of build and clear.
+void loadAllocateSharedTests(int testSize){
     try {
-        auto start = std::chrono::high_resolution_clock::now();
-        std::vector<std::unique_ptr<int>> pointers;
+        BumpArena arena(size_t(testSize) * 64);
+        BumpAllocator<int> allocator(arena);
+        auto resetArena = [&arena]() {
+            arena.reset();
+        };
+
+        std::cout << "\n";
+        runPointerBuildBenchmark<SharedPointer<int>>("MakeShared", "allocate_shared_make_shared", testSize, [](int i) {
+            return MakeShared<int>(i);
+        }, resetArena);
+        runPointerBuildBenchmark<SharedPointer<int>>("AllocateShared, bump allocator", "allocate_shared_bump", testSize,
+                                                     [&allocator](int i) {
+            return AllocateShared<int>(allocator, i);
+        }, resetArena);
+        runPointerBuildBenchmark<std::shared_ptr<int>>("std::allocate_shared, bump allocator", "std_allocate_shared_bump",
+                                                       testSize, [&allocator](int i) {
+            return std::allocate_shared<int>(allocator, i);
+        }, resetArena);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+void loadWeakPointerLockTests(int testSize){
+    try {
+        std::vector<SharedPointer<int>> pointers;
+        std::vector<WeakPointer<int>> weakPointers;
 
         for (int i = 0; i < testSize; ++i) {
-            pointers.push_back(std::unique_ptr<int>(new int(i)));
+            pointers.push_back(MakeShared<int>(i));
+            weakPointers.push_back(WeakPointer<int>(pointers.back()));
+        }
+
+        Benchmark benchmark = Benchmark::forSize(testSize);
+        benchmark.run([&](BenchmarkSample &sample) {
+            sample.measure("lock", testSize, [&]() {
+                long long sum = 0;
+                for (const auto &weak : weakPointers) {
+                    SharedPointer<int> locked = weak.lock();
+                    sum += *locked;
+                }
+                doNotOptimize(sum);
+            });
+        });
+        printPhaseStatistics(benchmark.statistics());
+        recordBenchmark("weak_pointer_lock", testSize, benchmark.statistics());
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+struct TrackedPayload {
+
+    inline static long long alive = 0;
+
+    char bytes[256];
 
-            /*if (i % (testSize / 100) == 0) {
-                printProgressBar(i + 1, testSize);
-            }*/
+    TrackedPayload() : bytes() {
+        ++alive;
+    }
+
+    ~TrackedPayload() {
+        --alive;
+    }
+};
+
+void loadWeakPointerReleaseTests(int testSize){
+    try {
+        long long aliveWithStrong = 0;
+        long long aliveWithWeak = 0;
+        long long expired = 0;
+
+        Benchmark benchmark = Benchmark::forSize(testSize);
+        benchmark.run([&](BenchmarkSample &sample) {
+            std::vector<WeakPointer<TrackedPayload>> separate;
+            std::vector<WeakPointer<TrackedPayload>> fused;
+            std::vector<SharedPointer<TrackedPayload>> pointers;
+
+            for (int i = 0; i < testSize; ++i) {
+                pointers.push_back(SharedPointer<TrackedPayload>(new TrackedPayload()));
+                separate.push_back(WeakPointer<TrackedPayload>(pointers.back()));
+                pointers.push_back(MakeShared<TrackedPayload>());
+                fused.push_back(WeakPointer<TrackedPayload>(pointers.back()));
+            }
+            aliveWithStrong = TrackedPayload::alive;
+
+            sample.measure("release_strong", testSize * 2, [&]() {
+                pointers.clear();
+            });
+            aliveWithWeak = TrackedPayload::alive;
+
+            expired = 0;
+            for (int i = 0; i < testSize; ++i) {
+                expired += separate[i].expired() + fused[i].expired();
+            }
+        });
+        printPhaseStatistics(benchmark.statistics());
+        recordBenchmark("weak_pointer_release", testSize, benchmark.statistics());
+
+        std::cout << "    Alive with strong references: " << aliveWithStrong
+                  << ", alive with only weak references: " << aliveWithWeak
+                  << ", expired: " << expired
+                  << ", bytes pinned by control blocks: "
+                  << testSize * sizeof(SharedControlBlockPointer<TrackedPayload, NonAtomicCounting>) << " (new) / "
+                  << testSize * sizeof(SharedControlBlockInplace<TrackedPayload, NonAtomicCounting>) << " (MakeShared)\n";
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+void loadLinkedListUniquePointerTests(int testSize){
+    try {
+        runLinkedListBenchmark<LinkedListUniquePointer<int>>("linked_list_unique_pointer", testSize);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+void loadLinkedListSharedPointerTests(int testSize){
+    try {
+        runLinkedListBenchmark<LinkedListSharedPointer<int>>("linked_list_shared_pointer", testSize);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+void loadLinkedListSharedPointerAllocationTests(int testSize){
+    try {
+        Benchmark benchmark = Benchmark::forSize(testSize);
+        benchmark.run([&](BenchmarkSample &sample) {
+            LinkedListSharedPointer<int> list;
+
+            sample.measure("push_front", testSize, [&]() {
+                for (int i = 0; i < testSize; ++i) {
+                    list.push_front(i);
+                }
+            });
+            sample.measure("clear", testSize, [&]() {
+                list.clear();
+            });
+        });
+        printPhaseStatistics(benchmark.statistics());
+        recordBenchmark("linked_list_shared_pointer_allocations", testSize, benchmark.statistics());
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+// One list serves every sample, so after the warm-up the pool runs from its
+// free list; RSS growth is taken after the first build.
+template<typename List>
+void measureLinkedListAllocator(const char *name, const char *variant, int testSize) {
+    releaseFreeMemory();
+    size_t residentBefore = currentResidentMemory();
+    size_t residentGrowth = 0;
+    bool firstBuild = true;
+    List list;
+
+    Benchmark benchmark = Benchmark::forSize(testSize);
+    benchmark.run([&](BenchmarkSample &sample) {
+        sample.measure("construction", testSize, [&]() {
+            for (int i = 0; i < testSize; ++i) {
+                list.push_front(i);
+            }
+        });
+        if (firstBuild) {
+            size_t residentAfter = currentResidentMemory();
+            residentGrowth = residentAfter > residentBefore ? residentAfter - residentBefore : 0;
+            firstBuild = false;
         }
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-        std::cout << "Time: " << duration << " ms\n";
+        sample.measure("destruction", testSize, [&]() {
+            list.clear();
+        });
+    });
+    std::cout << "    " << name << " (RSS growth " << residentGrowth / 1024 << " KB):";
+    printPhaseStatistics(benchmark.statistics());
+    recordBenchmark(variant, testSize, benchmark.statistics());
+}
+
+void loadLinkedListPoolAllocatorTests(int testSize){
+    try {
+        std::cout << "\n";
+        measureLinkedListAllocator<LinkedListUniquePointer<int>>("Unique pointer list, malloc",
+                                                                 "linked_list_unique_pointer_malloc", testSize);
+        measureLinkedListAllocator<LinkedListUniquePointer<int, PoolAllocator>>("Unique pointer list, pool",
+                                                                                "linked_list_unique_pointer_pool",
+                                                                                testSize);
+        PoolAllocator::release<NodeUniquePointer<int, PoolAllocator>>();
+        measureLinkedListAllocator<LinkedListSharedPointer<int>>("Shared pointer list, malloc",
+                                                                 "linked_list_shared_pointer_malloc", testSize);
+        measureLinkedListAllocator<LinkedListSharedPointer<int, PoolAllocator>>("Shared pointer list, pool",
+                                                                                "linked_list_shared_pointer_pool",
+                                                                                testSize);
+        PoolAllocator::release<NodeSharedPointer<int, PoolAllocator>>();
+        PoolAllocator::release<NodeSharedPointer<int, PoolAllocator>::ControlBlock>();
     } catch (const std::exception &e) {
         std::cout << "Failed with exception: " << e.what() << "\n";
     } catch (...) {
@@ -118,24 +872,418 @@ void loadStdUniquePointerTests(int testSize){
     }
 }
 
-void loadStdSharedPointerTests(int testSize){
+// What a tagged pointer replaces: a pointer and a small flag side by side, padded to 16 bytes.
+struct FlaggedUniquePointer {
+    UniquePointer<long long> pointer;
+    uint8_t flags;
+};
+
+struct FlaggedValue {
+    long long value;
+    uint8_t flags;
+};
+
+template<typename Container, typename Push, typename Sum>
+void measureTaggedPointerFootprint(const char *name, const char *variant, size_t elementBytes, int testSize,
+                                   Push push, Sum sum) {
+    releaseFreeMemory();
+    size_t residentBefore = currentResidentMemory();
+    size_t residentGrowth = 0;
+    {
+        Container container;
+        for (int i = 0; i < testSize; ++i) {
+            push(container, i);
+        }
+        size_t residentAfter = currentResidentMemory();
+        residentGrowth = residentAfter > residentBefore ? residentAfter - residentBefore : 0;
+    }
+
+    Benchmark benchmark = Benchmark::forSize(testSize);
+    benchmark.run([&](BenchmarkSample &sample) {
+        auto container = std::make_unique<Container>();
+
+        sample.measure("construction", testSize, [&]() {
+            for (int i = 0; i < testSize; ++i) {
+                push(*container, i);
+            }
+        });
+        sample.measure("traversal", testSize, [&]() {
+            doNotOptimize(sum(*container));
+        });
+        sample.measure("destruction", testSize, [&]() {
+            container.reset();
+        });
+    });
+    std::cout << "    " << name << " (" << elementBytes << " B per element, RSS growth " << residentGrowth / 1024
+              << " KB):";
+    printPhaseStatistics(benchmark.statistics());
+    recordBenchmark(variant, testSize, benchmark.statistics());
+}
+
+void loadTaggedPointerTests(int testSize){
     try {
-        auto start = std::chrono::high_resolution_clock::now();
-        std::vector<std::shared_ptr<int>> pointers;
+        using TaggedPointer = TaggedUniquePointer<long long, 2>;
+        using TaggedList = LinkedListUniquePointer<long long, NewDeleteAllocator, TaggedLink>;
+        using TaggedPoolList = LinkedListUniquePointer<long long, PoolAllocator, TaggedLink>;
+
+        std::cout << "\n";
+        measureTaggedPointerFootprint<std::vector<FlaggedUniquePointer>>(
+                "UniquePointer and flag", "flagged_unique_pointer", sizeof(FlaggedUniquePointer), testSize,
+                [](std::vector<FlaggedUniquePointer> &pointers, int i) {
+            pointers.push_back({UniquePointer<long long>(new long long(i)), uint8_t(i & 3)});
+        }, [](const std::vector<FlaggedUniquePointer> &pointers) {
+            long long sum = 0;
+            for (const auto &entry : pointers) {
+                sum += *entry.pointer + entry.flags;
+            }
+            return sum;
+        });
+        measureTaggedPointerFootprint<std::vector<TaggedPointer>>(
+                "TaggedUniquePointer", "tagged_unique_pointer", sizeof(TaggedPointer), testSize,
+                [](std::vector<TaggedPointer> &pointers, int i) {
+            pointers.emplace_back(new long long(i), uintptr_t(i & 3));
+        }, [](const std::vector<TaggedPointer> &pointers) {
+            long long sum = 0;
+            for (const auto &pointer : pointers) {
+                sum += *pointer + pointer.tag();
+            }
+            return sum;
+        });
+        measureTaggedPointerFootprint<LinkedListUniquePointer<FlaggedValue>>(
+                "Unique pointer list, flag in node", "linked_list_flagged_unique_pointer",
+                sizeof(NodeUniquePointer<FlaggedValue>), testSize, [](LinkedListUniquePointer<FlaggedValue> &list, int i) {
+            list.push_front({i, uint8_t(i & 3)});
+        }, [](const LinkedListUniquePointer<FlaggedValue> &list) {
+            long long sum = 0;
+            list.for_each([&sum](const FlaggedValue &entry) {
+                sum += entry.value + entry.flags;
+            });
+            return sum;
+        });
+        measureTaggedPointerFootprint<TaggedList>(
+                "Tagged unique pointer list, flag in link", "linked_list_tagged_unique_pointer",
+                sizeof(NodeUniquePointer<long long, NewDeleteAllocator, TaggedLink>), testSize,
+                [](TaggedList &list, int i) {
+            list.push_front(i, uintptr_t(i & 3));
+        }, [](const TaggedList &list) {
+            long long sum = 0;
+            list.for_each_flagged([&sum](long long value, uintptr_t flags) {
+                sum += value + flags;
+            });
+            return sum;
+        });
+
+        // malloc rounds both node sizes up to the same chunk; the pool shows the difference.
+        measureTaggedPointerFootprint<LinkedListUniquePointer<FlaggedValue, PoolAllocator>>(
+                "Unique pointer list, flag in node, pool", "linked_list_flagged_unique_pointer_pool",
+                sizeof(NodeUniquePointer<FlaggedValue, PoolAllocator>), testSize,
+                [](LinkedListUniquePointer<FlaggedValue, PoolAllocator> &list, int i) {
+            list.push_front({i, uint8_t(i & 3)});
+        }, [](const LinkedListUniquePointer<FlaggedValue, PoolAllocator> &list) {
+            long long sum = 0;
+            list.for_each([&sum](const FlaggedValue &entry) {
+                sum += entry.value + entry.flags;
+            });
+            return sum;
+        });
+        PoolAllocator::release<NodeUniquePointer<FlaggedValue, PoolAllocator>>();
+        measureTaggedPointerFootprint<TaggedPoolList>(
+                "Tagged unique pointer list, flag in link, pool", "linked_list_tagged_unique_pointer_pool",
+                sizeof(NodeUniquePointer<long long, PoolAllocator, TaggedLink>), testSize,
+                [](TaggedPoolList &list, int i) {
+            list.push_front(i, uintptr_t(i & 3));
+        }, [](const TaggedPoolList &list) {
+            long long sum = 0;
+            list.for_each_flagged([&sum](long long value, uintptr_t flags) {
+                sum += value + flags;
+            });
+            return sum;
+        });
+        PoolAllocator::release<NodeUniquePointer<long long, PoolAllocator, TaggedLink>>();
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+template<typename List>
+void measureLinkedListTeardown(const char *name, const char *variant, int testSize) {
+    Benchmark benchmark = Benchmark::forSize(testSize);
+    benchmark.run([&](BenchmarkSample &sample) {
+        List list;
+
+        sample.measure("construction", testSize, [&]() {
+            for (int i = 0; i < testSize; ++i) {
+                list.push_front(i);
+            }
+        });
+        sample.measure("destruction", testSize, [&]() {
+            list.clear();
+        });
+    });
+    std::cout << "    " << name << ":";
+    printPhaseStatistics(benchmark.statistics());
+    recordBenchmark(variant, testSize, benchmark.statistics());
+}
+
+void loadLinkedListTeardownTests(int testSize){
+    try {
+        std::cout << "\n";
+        measureLinkedListTeardown<LinkedListUniquePointer<int>>("Unique pointer list", "linked_list_teardown_unique",
+                                                                testSize);
+        measureLinkedListTeardown<LinkedListUniquePointer<int, PoolAllocator>>("Unique pointer list, pool",
+                                                                               "linked_list_teardown_unique_pool",
+                                                                               testSize);
+        PoolAllocator::release<NodeUniquePointer<int, PoolAllocator>>();
+        measureLinkedListTeardown<LinkedListSharedPointer<int>>("Shared pointer list", "linked_list_teardown_shared",
+                                                                testSize);
+        measureLinkedListTeardown<LinkedListSharedPointer<int, PoolAllocator>>("Shared pointer list, pool",
+                                                                               "linked_list_teardown_shared_pool",
+                                                                               testSize);
+        PoolAllocator::release<NodeSharedPointer<int, PoolAllocator>>();
+        PoolAllocator::release<NodeSharedPointer<int, PoolAllocator>::ControlBlock>();
+
+        Benchmark benchmark = Benchmark::forSize(testSize);
+        benchmark.run([&](BenchmarkSample &sample) {
+            UniquePointer<NodeUniquePointer<int>> chain;
+            for (int i = 0; i < testSize; ++i) {
+                UniquePointer<NodeUniquePointer<int>> node(new NodeUniquePointer<int>(i));
+                node->next = std::move(chain);
+                chain = std::move(node);
+            }
+
+            sample.measure("destruction", testSize, [&]() {
+                chain.reset();
+            });
+        });
+        std::cout << "    Detached unique pointer chain:";
+        printPhaseStatistics(benchmark.statistics());
+        recordBenchmark("linked_list_teardown_detached_chain", testSize, benchmark.statistics());
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+void loadLinkedListIndexedTests(int testSize){
+    try {
+        runLinkedListBenchmark<LinkedListIndexed<int>>("linked_list_indexed", testSize);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+void loadLinkedListUnrolledTests(int testSize){
+    try {
+        std::cout << "\n    4 elements per node:";
+        runLinkedListBenchmark<LinkedListUnrolled<int, 4>>("linked_list_unrolled_4", testSize);
+        std::cout << "    16 elements per node:";
+        runLinkedListBenchmark<LinkedListUnrolled<int, 16>>("linked_list_unrolled_16", testSize);
+        std::cout << "    64 elements per node:";
+        runLinkedListBenchmark<LinkedListUnrolled<int, 64>>("linked_list_unrolled_64", testSize);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+template<typename List>
+long long sumLinkedList(const List &list) {
+    long long sum = 0;
+    list.for_each([&sum](int value) {
+        sum += value;
+    });
+    return sum;
+}
+
+void loadLinkedListTraversalTests(int testSize){
+    try {
+        LinkedListUniquePointer<int> uniqueList;
+        LinkedListSharedPointer<int> sharedList;
+        LinkedListIndexed<int> indexedList;
+        LinkedListUnrolled<int> unrolledList;
 
         for (int i = 0; i < testSize; ++i) {
-            pointers.push_back(std::make_shared<int>(i));
+            uniqueList.push_front(i);
+            sharedList.push_front(i);
+            indexedList.push_front(i);
+            unrolledList.push_front(i);
+        }
+
+        Benchmark benchmark = Benchmark::forSize(testSize);
+        benchmark.run([&](BenchmarkSample &sample) {
+            sample.measure("unique_pointer_scan", testSize, [&]() {
+                doNotOptimize(sumLinkedList(uniqueList));
+            });
+            sample.measure("shared_pointer_scan", testSize, [&]() {
+                doNotOptimize(sumLinkedList(sharedList));
+            });
+            sample.measure("indexed_scan", testSize, [&]() {
+                doNotOptimize(sumLinkedList(indexedList));
+            });
+            sample.measure("unrolled_scan", testSize, [&]() {
+                doNotOptimize(sumLinkedList(unrolledList));
+            });
+        });
+        printPhaseStatistics(benchmark.statistics());
+        recordBenchmark("linked_list_traversal", testSize, benchmark.statistics());
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+template<typename T>
+struct MutexLinkedList {
+
+    std::mutex mutex;
+    LinkedListUniquePointer<T> list;
+
+    void push_front(const T& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        list.push_front(value);
+    }
+
+    bool pop_front(T& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (list.null()) {
+            return false;
+        }
+        value = list.get_front();
+        list.pop_front();
+        return true;
+    }
+};
+
+// Every thread alternates push_front and pop_front; testSize counts both.
+template<typename Stack>
+void runConcurrentStackOperations(Stack &stack, int threadCount, int testSize) {
+    std::vector<std::thread> threads;
+    int pairsPerThread = testSize / threadCount / 2;
+
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&stack, pairsPerThread]() {
+            long long sum = 0;
+            int value = 0;
+
+            for (int i = 0; i < pairsPerThread; ++i) {
+                stack.push_front(i);
+                if (stack.pop_front(value)) {
+                    sum += value;
+                }
+            }
+            doNotOptimize(sum);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void loadConcurrentStackTests(int testSize){
+    loadConcurrentStackTests(testSize, defaultThreadCounts());
+}
+
+void loadConcurrentStackTests(int testSize, const std::vector<int> &threadCounts){
+    try {
+        std::cout << "\n";
+        for (int threadCount : threadCounts) {
+            ConcurrentStack<int> lockFree;
+            MutexLinkedList<int> locked;
 
-            /*if (i % (testSize / 100) == 0) {
-                printProgressBar(i + 1, testSize);
-            }*/
+            Benchmark benchmark = Benchmark::forSize(testSize);
+            benchmark.run([&](BenchmarkSample &sample) {
+                sample.measure("lock_free", testSize, [&]() {
+                    runConcurrentStackOperations(lockFree, threadCount, testSize);
+                });
+                sample.measure("mutex", testSize, [&]() {
+                    runConcurrentStackOperations(locked, threadCount, testSize);
+                });
+            });
+
+            std::vector<PhaseStatistics> statistics = benchmark.statistics();
+            std::cout << "    Threads: " << threadCount;
+            printPhaseStatistics(statistics);
+            std::cout << "    Throughput:";
+            for (size_t i = 0; i < statistics.size(); ++i) {
+                std::cout << (i ? ", " : " ") << statistics[i].phase << " "
+                          << 1000.0 / std::max(statistics[i].median, 1e-9) << " Mops/s";
+            }
+            std::cout << "\n";
+            recordBenchmark("concurrent_stack", testSize, statistics, threadCount);
         }
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-        std::cout << "Time: " << duration << " ms\n";
     } catch (const std::exception &e) {
         std::cout << "Failed with exception: " << e.what() << "\n";
     } catch (...) {
         std::cout << "Failed with unknown exception\n";
     }
-}
\ No newline at end of file
+}
+
+template<typename Counting>
+struct IntrusiveInt : IntrusiveCounted<IntrusiveInt<Counting>, Counting> {
+
+    int value;
+
+    explicit IntrusiveInt(int v) : value(v) {}
+
+    operator int() const {
+        return value;
+    }
+};
+
+void loadIntrusivePointerTests(int testSize){
+    try {
+        std::cout << "\n    Non-atomic counts:";
+        runPointerVectorBenchmark<IntrusivePointer<IntrusiveInt<NonAtomicCounting>>>("intrusive_pointer", testSize, [](int i) {
+            return MakeIntrusive<IntrusiveInt<NonAtomicCounting>>(i);
+        }, copyPointers<IntrusivePointer<IntrusiveInt<NonAtomicCounting>>>);
+        std::cout << "    Atomic counts:";
+        runPointerVectorBenchmark<IntrusivePointer<IntrusiveInt<AtomicCounting>>>("intrusive_pointer_atomic", testSize, [](int i) {
+            return MakeIntrusive<IntrusiveInt<AtomicCounting>>(i);
+        }, copyPointers<IntrusivePointer<IntrusiveInt<AtomicCounting>>>);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+void loadLinkedListIntrusivePointerTests(int testSize){
+    try {
+        runLinkedListBenchmark<LinkedListIntrusivePointer<int>>("linked_list_intrusive_pointer", testSize);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+void loadStdUniquePointerTests(int testSize){
+    try {
+        runPointerVectorBenchmark<std::unique_ptr<int>>("std_unique_ptr", testSize, [](int i) {
+            return std::unique_ptr<int>(new int(i));
+        }, movePointers<std::unique_ptr<int>>);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
+
+void loadStdSharedPointerTests(int testSize){
+    try {
+        runPointerVectorBenchmark<std::shared_ptr<int>>("std_shared_ptr", testSize, [](int i) {
+            return std::make_shared<int>(i);
+        }, copyPointers<std::shared_ptr<int>>);
+    } catch (const std::exception &e) {
+        std::cout << "Failed with exception: " << e.what() << "\n";
+    } catch (...) {
+        std::cout << "Failed with unknown exception\n";
+    }
+}
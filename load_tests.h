@@ -1,8 +1,38 @@
 #pragma once
 
+#include <vector>
+
 void loadUniquePointerTests(int);
+void loadUniquePointerDeleterTests(int);
+void loadUniqueArrayTests(int);
+void loadCompactPointerTests(int);
 void loadSharedPointerTests(int);
+void loadSharedPointerDeferredReleaseTests(int);
+void loadMakeSharedPointerTests(int);
+void loadSharedPointerChurnTests(int);
+void loadSharedPointerThreadTests(int);
+void loadSharedPointerThreadTests(int, const std::vector<int> &);
+void loadBiasedCountingTests(int);
+void loadBiasedCountingTests(int, const std::vector<int> &);
+void loadAtomicSharedPointerTests(int);
+void loadAtomicSharedPointerTests(int, const std::vector<int> &);
+void loadAllocateSharedTests(int);
+void loadWeakPointerLockTests(int);
+void loadWeakPointerReleaseTests(int);
 void loadLinkedListUniquePointerTests(int);
 void loadLinkedListSharedPointerTests(int);
+void loadLinkedListSharedPointerAllocationTests(int);
+void loadLinkedListPoolAllocatorTests(int);
+void loadLinkedListTeardownTests(int);
+void loadTaggedPointerTests(int);
+void loadLinkedListIndexedTests(int);
+void loadLinkedListUnrolledTests(int);
+void loadConcurrentStackTests(int);
+void loadConcurrentStackTests(int, const std::vector<int> &);
+void loadLinkedListTraversalTests(int);
 void loadStdUniquePointerTests(int);
 void loadStdSharedPointerTests(int);
+void loadIntrusivePointerTests(int);
+void loadLinkedListIntrusivePointerTests(int);
+
+std::vector<int> defaultThreadCounts();
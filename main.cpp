@@ -1,6 +1,11 @@
 #include "menu.h"
+#include "command_line.h"
 
-int main() {
+int main(int argc, char *argv[]) {
+
+    if (argc > 1) {
+        return runCommandLine(argc, argv);
+    }
 
     openMenu();
 
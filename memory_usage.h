@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+size_t currentResidentMemory();
+size_t peakResidentMemory();
+// Restarts the peak from the current RSS; false where /proc/self/clear_refs is unavailable.
+bool resetPeakResidentMemory();
+void releaseFreeMemory();
@@ -11,7 +11,9 @@ void functions(){
     std::cout << "4. Linked list shared pointer tests\n";
     std::cout << "5. Std unique pointer tests\n";
     std::cout << "6. Std shared pointer tests\n";
-    std::cout << "7. Exit\n";
+    std::cout << "7. Weak pointer tests\n";
+    std::cout << "8. Intrusive pointer tests\n";
+    std::cout << "9. Exit\n";
     std::cout << "Input number of function : ";
 }
 
@@ -20,8 +22,8 @@ void openMenu(){
     int n;
     std::cin >> n;
     std::cout << "\n";
-    while (n != 7) {
-        if ((n < 1) || (n >7))
+    while (n != 9) {
+        if ((n < 1) || (n > 9))
         {
             std::cout << "Wrong number input, please try again.\n\n";
             functions();
@@ -53,6 +55,14 @@ void openMenu(){
                     functions();
                     break;
                 case (7):
+                    WeakPointerTests();
+                    functions();
+                    break;
+                case (8):
+                    IntrusivePointerTests();
+                    functions();
+                    break;
+                case (9):
                     exit(0);
             }
         }
@@ -0,0 +1,133 @@
+#include "perf_counters.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstdint>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char *const counterNames[perfCounterCount] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses"
+};
+
+static bool countersEnabled = false;
+
+const char *perfCounterName(size_t counter) {
+    return counter < perfCounterCount ? counterNames[counter] : "";
+}
+
+bool perfCountersEnabled() {
+    return countersEnabled;
+}
+
+#ifdef __linux__
+
+static int descriptors[perfCounterCount] = {-1, -1, -1, -1, -1};
+static bool opened = false;
+
+static uint64_t cacheMissConfig(uint64_t cache) {
+    return cache | (uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8) | (uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+}
+
+static int openCounter(uint32_t type, uint64_t config) {
+    perf_event_attr attributes{};
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.disabled = 1;
+    attributes.inherit = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return int(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+}
+
+static void openCounters() {
+    opened = true;
+    descriptors[perfCycles] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    descriptors[perfInstructions] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    descriptors[perfL1dMisses] = openCounter(PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_L1D));
+    descriptors[perfLlcMisses] = openCounter(PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_LL));
+    descriptors[perfDtlbMisses] = openCounter(PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_DTLB));
+    int failure = errno;
+
+    bool any = false;
+    for (int descriptor : descriptors) {
+        any = any || descriptor >= 0;
+    }
+    if (!any) {
+        std::cerr << "Hardware counters unavailable (" << std::strerror(failure)
+                  << "), check /proc/sys/kernel/perf_event_paranoid\n";
+    }
+}
+
+void enablePerfCounters(bool enabled) {
+    countersEnabled = enabled;
+    if (enabled && !opened) {
+        openCounters();
+    }
+}
+
+void startPerfCounters() {
+    if (!countersEnabled) {
+        return;
+    }
+    for (int descriptor : descriptors) {
+        if (descriptor >= 0) {
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+PerfCounts stopPerfCounters() {
+    PerfCounts counts;
+    counts.fill(-1);
+    if (!countersEnabled) {
+        return counts;
+    }
+
+    for (size_t counter = 0; counter < perfCounterCount; ++counter) {
+        if (descriptors[counter] >= 0) {
+            ioctl(descriptors[counter], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (size_t counter = 0; counter < perfCounterCount; ++counter) {
+        uint64_t values[3];
+        if (descriptors[counter] < 0 || read(descriptors[counter], values, sizeof(values)) != ssize_t(sizeof(values))) {
+            continue;
+        }
+        // Scale up when the kernel multiplexed the counter for part of the phase.
+        if (values[2] == 0) {
+            continue;
+        }
+        counts[counter] = double(values[0]) * double(values[1]) / double(values[2]);
+    }
+
+    return counts;
+}
+
+#else
+
+void enablePerfCounters(bool enabled) {
+    if (enabled) {
+        std::cerr << "Hardware counters are only supported on Linux\n";
+    }
+    countersEnabled = false;
+}
+
+void startPerfCounters() {}
+
+PerfCounts stopPerfCounters() {
+    PerfCounts counts;
+    counts.fill(-1);
+    return counts;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+enum PerfCounter {
+    perfCycles,
+    perfInstructions,
+    perfL1dMisses,
+    perfLlcMisses,
+    perfDtlbMisses,
+    perfCounterCount
+};
+
+// A negative value means the counter could not be read.
+using PerfCounts = std::array<double, perfCounterCount>;
+
+const char *perfCounterName(size_t counter);
+
+// Counters are off until enabled; while off, or when perf events are unavailable,
+// stopPerfCounters reports every value as negative.
+void enablePerfCounters(bool enabled);
+bool perfCountersEnabled();
+
+void startPerfCounters();
+PerfCounts stopPerfCounters();
@@ -1,15 +1,29 @@
 #include "pointer_tests.h"
+#include "allocation_counter.h"
 #include "shared_pointer.h"
 #include "unique_pointer.h"
+#include "weak_pointer.h"
+#include "atomic_shared_pointer.h"
+#include "compact_pointer.h"
+#include "tagged_pointer.h"
+#include "intrusive_pointer.h"
 #include "test_structure.h"
+#include "pool_allocator.h"
 #include "load_tests.h"
 
 #include <chrono>
 #include <iostream>
 #include "memory"
 #include "cassert"
+#include <atomic>
+#include <string>
+#include <thread>
 
 
+// Whether an array pointer can adopt a raw pointer through reset().
+template<typename Array, typename T>
+constexpr bool resetsFromRawPointer = requires (Array &array, T *p) { array.reset(p); };
+
 void UniquePointerTests() {
     std::cout << "Unique pointer tests:\n\n";
 
@@ -105,6 +119,144 @@ void UniquePointerTests() {
         }
     }
 
+    std::cout << "  Functional test 5 (custom deleters): ";
+    {
+        try {
+            struct CountingDelete {
+                int *calls;
+
+                void operator()(int *p) const {
+                    ++*calls;
+                    delete p;
+                }
+            };
+
+            struct ArrayDelete {
+                void operator()(int *p) const {
+                    delete[] p;
+                }
+            };
+
+            static_assert(sizeof(UniquePointer<int>) == sizeof(int *));
+            static_assert(sizeof(UniquePointer<int[]>) == sizeof(int *));
+            static_assert(sizeof(UniquePointer<int, ArrayDelete>) == sizeof(int *));
+            static_assert(sizeof(UniquePointer<int[], ArrayDelete>) == sizeof(int *));
+            static_assert(sizeof(UniquePointer<int, PoolDelete<int>>) == sizeof(int *));
+            static_assert(sizeof(UniquePointer<int, CountingDelete>) == 2 * sizeof(int *));
+
+            int calls = 0;
+            {
+                UniquePointer<int, CountingDelete> p1(new int(10), CountingDelete{&calls});
+                UniquePointer<int, CountingDelete> p2 = std::move(p1);
+                p2.reset(new int(20));
+                assert(calls == 1 && *p2 == 20);
+            }
+            assert(calls == 2);
+
+            UniquePointer<int[], ArrayDelete> array(new int[3]{1, 2, 3});
+            assert(array[2] == 3);
+
+            // Function pointer deleters must be given, a default one would be null.
+            using FunctionDelete = void (*)(int *);
+            static_assert(!std::is_default_constructible_v<UniquePointer<int, FunctionDelete>>);
+            static_assert(!std::is_constructible_v<UniquePointer<int, FunctionDelete>, int *>);
+            static int functionCalls = 0;
+            {
+                UniquePointer<int, FunctionDelete> p3(new int(30), [](int *p) {
+                    ++functionCalls;
+                    delete p;
+                });
+                assert(*p3 == 30);
+            }
+            assert(functionCalls == 1);
+
+            std::cout << "Passed\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 6 (compact unique pointer): ";
+    {
+        try {
+            static_assert(sizeof(CompactUniquePointer<int>) == 4);
+
+            CompactUniquePointer<int> p1 = MakeCompactUnique<int>(10);
+            CompactUniquePointer<int> p2 = std::move(p1);
+            assert(p1.null() && *p2 == 10);
+
+            int *address = p2.get();
+            p2.reset();
+            CompactUniquePointer<int> p3 = MakeCompactUnique<int>(20);
+            std::cout << (p2.null() && p3.get() == address && *p3 == 20 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 7 (tagged unique pointer): ";
+    {
+        try {
+            using Tagged = TaggedUniquePointer<long long, 3>;
+            static_assert(sizeof(Tagged) == sizeof(long long *) && Tagged::maxTag == 7);
+
+            Tagged p1(new long long(10), 5);
+            Tagged p2 = std::move(p1);
+            assert(p1.null() && *p2 == 10 && p2.tag() == 5);
+
+            p2.set_tag(2);
+            *p2 += 1;
+            p2.reset(new long long(20));
+            std::cout << (*p2 == 20 && p2.tag() == 2 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 8 (sized and aligned arrays): ";
+    {
+        try {
+            UniqueArray<int> zeroed = MakeUniqueArray<int>(100);
+            assert(zeroed.size() == 100 && reinterpret_cast<uintptr_t>(zeroed.get()) % 64 == 0);
+            int sum = 0;
+            for (int value : zeroed) {
+                sum += value;
+            }
+
+            UniqueArray<std::string> strings = MakeUniqueArrayForOverwrite<std::string>(3);
+            strings[2] = "last";
+            bool outOfRange = false;
+            try {
+                strings.at(3);
+            } catch (const std::out_of_range &) {
+                outOfRange = true;
+            }
+
+            UniqueArray<std::string> moved = std::move(strings);
+
+            // Only emptying resets are allowed, a raw pointer would inherit the old length.
+            static_assert(!resetsFromRawPointer<UniqueArray<int>, int>);
+            static_assert(resetsFromRawPointer<UniquePointer<int[]>, int>);
+            zeroed.reset();
+            assert(zeroed.null() && zeroed.size() == 0);
+            zeroed = MakeUniqueArray<int>(10);
+
+            std::cout << (sum == 0 && outOfRange && strings.size() == 0 && moved.size() == 3 &&
+                          moved.at(2) == "last" && moved[0].empty() && zeroed.size() == 10 ? "Passed" : "Failed")
+                      << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
     std::cout << "  Load test 1 (small): ";
     {
         int testSize = 1000;
@@ -122,6 +274,30 @@ void UniquePointerTests() {
         int testSize = 10'000'000;
         loadUniquePointerTests(testSize);
     }
+
+    std::cout << "  Load test 4 (deleters, with destruction): ";
+    {
+        int testSize = 10'000'000;
+        loadUniquePointerDeleterTests(testSize);
+    }
+
+    std::cout << "  Load test 5 (compact pointers, build, random access and scan): ";
+    {
+        int testSize = 10'000'000;
+        loadCompactPointerTests(testSize);
+    }
+
+    std::cout << "  Load test 6 (flags in pointer bits, memory footprint): ";
+    {
+        int testSize = 10'000'000;
+        loadTaggedPointerTests(testSize);
+    }
+
+    std::cout << "  Load test 7 (large buffers, MakeUniqueArray vs std::make_unique): ";
+    {
+        int testSize = 100'000'000;
+        loadUniqueArrayTests(testSize);
+    }
     std::cout << "\n\n";
 }
 
@@ -201,35 +377,138 @@ void SharedPointerTests() {
         }
     }
 
-    std::cout << "  Load test 1 (small): ";
+    std::cout << "  Functional test 5 (make shared): ";
     {
-        int testSize = 1000;
-        loadSharedPointerTests(testSize);
+        try {
+            struct Pair {
+                int first;
+                double second;
+                Pair(int f, double s) : first(f), second(s) {}
+            };
+
+            SharedPointer<Pair> p1 = MakeShared<Pair>(10, 2.5);
+            SharedPointer<Pair> p2 = p1;
+
+            assert(p1.use_count() == 2);
+            assert(p2->first == 10 && p2->second == 2.5);
+
+            std::cout << "Passed\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
     }
 
-    std::cout << "  Load test 2 (medium): ";
+    std::cout << "  Functional test 6 (move semantics): ";
     {
-        int testSize = 100'000;
-        loadSharedPointerTests(testSize);
+        try {
+            class C1 {
+            public:
+                virtual ~C1() = default;
+            };
+
+            class C2 : public C1 {};
+
+            SharedPointer<int> p1(new int(10));
+            SharedPointer<int> p2 = std::move(p1);
+
+            assert(p1.null() && p1.use_count() == 0);
+            assert(*p2 == 10 && p2.use_count() == 1);
+
+            SharedPointer<int> p3(new int(20));
+            p3 = std::move(p2);
+
+            assert(p2.null() && *p3 == 10 && p3.use_count() == 1);
+
+            SharedPointer<C2> derivedPtr(new C2());
+            SharedPointer<C1> basePtr = std::move(derivedPtr);
+
+            assert(derivedPtr.null() && basePtr.use_count() == 1);
+
+            std::cout << "Passed\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
     }
 
-    std::cout << "  Load test 3 (big): ";
+    std::cout << "  Functional test 7 (atomic reference counting): ";
     {
-        int testSize = 10'000'000;
-        loadSharedPointerTests(testSize);
+        try {
+            SharedPointer<int, AtomicCounting> p1 = MakeShared<int, AtomicCounting>(10);
+            std::vector<std::thread> threads;
+
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&p1]() {
+                    for (int i = 0; i < 10'000; ++i) {
+                        SharedPointer<int, AtomicCounting> copy(p1);
+                        assert(*copy == 10);
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+
+            std::cout << (p1.use_count() == 1 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
     }
-    std::cout << "\n\n";
-}
 
-void LinkedListUniquePointerTests() {
-    std::cout << "Linked list unique pointer tests:\n\n";
+    std::cout << "  Functional test 8 (null pointer without control block): ";
+    {
+        try {
+            SharedPointer<int> p1;
+            SharedPointer<int> p2(new int(10));
+            p2.reset();
 
-    std::cout << "  Functional test 1 (pushing elements): ";
+            assert(p1.control_block() == nullptr && p1.use_count() == 0);
+            assert(p2.control_block() == nullptr && p2.null());
+
+            std::cout << "Passed\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 9 (custom deleter and allocator): ";
     {
         try {
-            LinkedListUniquePointer<int> list;
-            list.push_front(10);
-            std::cout << (list.size() == 1 ? "Passed" : "Failed") << "\n";
+            int deleted = 0;
+            {
+                SharedPointer<int> p1(new int(10), [&deleted](int *p) {
+                    ++deleted;
+                    delete p;
+                });
+                SharedPointer<int> p2 = p1;
+                assert(*p2 == 10 && p2.use_count() == 2);
+
+                SharedPointer<int[]> array(new int[3]{1, 2, 3}, [&deleted](int *p) {
+                    ++deleted;
+                    delete[] p;
+                }, std::allocator<int>());
+                assert(array.get()[2] == 3);
+            }
+            assert(deleted == 2);
+
+            BumpArena arena(1024);
+            BumpAllocator<int> allocator(arena);
+            WeakPointer<int> weak;
+            {
+                SharedPointer<int> p3 = AllocateShared<int>(allocator, 30);
+                weak = p3;
+                assert(*p3 == 30 && arena.used() > 0);
+            }
+            assert(weak.expired());
+
+            std::cout << "Passed\n";
         } catch (const std::exception &e) {
             std::cout << "Failed with exception: " << e.what() << "\n";
         } catch (...) {
@@ -237,13 +516,42 @@ void LinkedListUniquePointerTests() {
         }
     }
 
-    std::cout << "  Functional test 2 (push, pop elements and size()): ";
+    std::cout << "  Functional test 10 (atomic shared pointer): ";
     {
         try {
-            LinkedListUniquePointer<int> list;
-            list.push_front(10);
-            list.pop_front();
-            std::cout << (list.size() == 0 ? "Passed" : "Failed") << "\n";
+            AtomicSharedPointer<int> slot(MakeShared<int, AtomicCounting>(1));
+            SharedPointer<int, AtomicCounting> first = slot.load();
+            assert(*first == 1 && first.use_count() == 2);
+
+            SharedPointer<int, AtomicCounting> stale = MakeShared<int, AtomicCounting>(5);
+            bool swapped = slot.compare_exchange(stale, MakeShared<int, AtomicCounting>(6));
+            assert(!swapped && stale.get() == first.get());
+
+            swapped = slot.compare_exchange(first, MakeShared<int, AtomicCounting>(2));
+            SharedPointer<int, AtomicCounting> previous = slot.exchange(MakeShared<int, AtomicCounting>(3));
+            assert(swapped && *previous == 2);
+
+            std::vector<std::thread> threads;
+            std::atomic<bool> torn = false;
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&slot, &torn, t]() {
+                    for (int i = 0; i < 10'000; ++i) {
+                        if (t == 0) {
+                            slot.store(MakeShared<int, AtomicCounting>(3 + i % 2));
+                        } else {
+                            SharedPointer<int, AtomicCounting> snapshot = slot.load();
+                            if (*snapshot != 3 && *snapshot != 4) {
+                                torn = true;
+                            }
+                        }
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+
+            std::cout << (!torn && *slot.load() >= 3 ? "Passed" : "Failed") << "\n";
         } catch (const std::exception &e) {
             std::cout << "Failed with exception: " << e.what() << "\n";
         } catch (...) {
@@ -251,11 +559,37 @@ void LinkedListUniquePointerTests() {
         }
     }
 
-    std::cout << "  Functional test 3 (null() function): ";
+    std::cout << "  Functional test 11 (deferred release): ";
     {
         try {
-            LinkedListUniquePointer<int> list;
-            std::cout << (list.null() ? "Passed" : "Failed") << "\n";
+            using DeferredPointer = SharedPointer<int, DeferredCounting<NonAtomicCounting>>;
+            int deleted = 0;
+            auto deleter = [&deleted](int *p) {
+                ++deleted;
+                delete p;
+            };
+            DeferredPointer survivor(new int(1), deleter);
+            {
+                DeferredReleaseScope scope;
+                std::vector<DeferredPointer> pointers;
+                for (int i = 0; i < 10'000; ++i) {
+                    pointers.push_back(DeferredPointer(new int(i), deleter));
+                }
+                pointers.push_back(survivor);
+                pointers.clear();
+                flushDeferredReleases();
+                assert(deleted == 10'000 && survivor.use_count() == 1);
+
+                pointers.push_back(DeferredPointer(new int(0), deleter));
+                pointers.clear();
+                assert(deleted == 10'000);
+
+                // Pointers with other policies ignore the scope.
+                SharedPointer<int>(new int(0), deleter).reset();
+                SharedPointer<int, AtomicCounting>(new int(0), deleter).reset();
+                assert(deleted == 10'002);
+            }
+            std::cout << (deleted == 10'003 && *survivor == 1 ? "Passed" : "Failed") << "\n";
         } catch (const std::exception &e) {
             std::cout << "Failed with exception: " << e.what() << "\n";
         } catch (...) {
@@ -263,14 +597,65 @@ void LinkedListUniquePointerTests() {
         }
     }
 
-    std::cout << "  Functional test 4 (clear() function): ";
+    std::cout << "  Functional test 12 (biased reference counting): ";
     {
         try {
-            LinkedListUniquePointer<int> list;
-            list.push_front(10);
-            list.push_front(20);
-            list.clear();
-            std::cout << (list.size() == 0 && list.null() ? "Passed" : "Failed") << "\n";
+            int deleted = 0;
+            auto deleter = [&deleted](int *p) {
+                ++deleted;
+                delete p;
+            };
+
+            SharedPointer<int, BiasedCounting> owned(new int(1), deleter);
+            SharedPointer<int, BiasedCounting> handedOff = owned;
+            assert(owned.use_count() == 2);
+            owned.reset();
+            std::thread([&handedOff]() {
+                handedOff.reset();
+            }).join();
+            assert(deleted == 0);
+            BiasedCounting::processQueuedReleases();
+            assert(deleted == 1);
+
+            SharedPointer<int, BiasedCounting> orphan;
+            std::thread([&orphan, &deleter]() {
+                orphan = SharedPointer<int, BiasedCounting>(new int(2), deleter);
+            }).join();
+            WeakPointer<int, BiasedCounting> weak(orphan);
+            orphan.reset();
+            assert(deleted == 2 && weak.expired());
+
+            // Finished threads hand their owner records on once nothing is biased towards them.
+            size_t records = BiasedCounting::ownerRecords();
+            for (int i = 0; i < 64; ++i) {
+                std::thread([&orphan, &deleter]() {
+                    SharedPointer<int, BiasedCounting> local(new int(3), deleter);
+                    orphan = local;
+                }).join();
+                orphan.reset();
+            }
+
+            std::cout << (deleted == 66 && BiasedCounting::ownerRecords() <= records + 1 ? "Passed" : "Failed")
+                      << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 13 (compact shared pointer): ";
+    {
+        try {
+            static_assert(sizeof(CompactSharedPointer<int>) == 4);
+
+            CompactSharedPointer<int> p1 = MakeCompactShared<int>(10);
+            CompactSharedPointer<int> p2 = p1;
+            assert(p1.use_count() == 2 && p1.get() == p2.get());
+
+            p1.reset();
+            CompactSharedPointer<int> p3 = std::move(p2);
+            std::cout << (p1.null() && p2.null() && p3.use_count() == 1 && *p3 == 10 ? "Passed" : "Failed") << "\n";
         } catch (const std::exception &e) {
             std::cout << "Failed with exception: " << e.what() << "\n";
         } catch (...) {
@@ -281,30 +666,84 @@ void LinkedListUniquePointerTests() {
     std::cout << "  Load test 1 (small): ";
     {
         int testSize = 1000;
-        loadLinkedListUniquePointerTests(testSize);
+        loadSharedPointerTests(testSize);
     }
 
     std::cout << "  Load test 2 (medium): ";
     {
         int testSize = 100'000;
-        loadLinkedListUniquePointerTests(testSize);
+        loadSharedPointerTests(testSize);
     }
 
     std::cout << "  Load test 3 (big): ";
     {
         int testSize = 10'000'000;
-        loadLinkedListUniquePointerTests(testSize);
+        loadSharedPointerTests(testSize);
+    }
+
+    std::cout << "  Load test 4 (make shared, small): ";
+    {
+        int testSize = 1000;
+        loadMakeSharedPointerTests(testSize);
+    }
+
+    std::cout << "  Load test 5 (make shared, medium): ";
+    {
+        int testSize = 100'000;
+        loadMakeSharedPointerTests(testSize);
+    }
+
+    std::cout << "  Load test 6 (make shared, big): ";
+    {
+        int testSize = 10'000'000;
+        loadMakeSharedPointerTests(testSize);
+    }
+
+    std::cout << "  Load test 7 (reference count churn): ";
+    {
+        int testSize = 100'000;
+        loadSharedPointerChurnTests(testSize);
+    }
+
+    std::cout << "  Load test 8 (multi-threaded copies): ";
+    {
+        int testSize = 10'000'000;
+        loadSharedPointerThreadTests(testSize);
+    }
+
+    std::cout << "  Load test 9 (steady state, second round of build and clear): ";
+    {
+        int testSize = 10'000'000;
+        loadAllocateSharedTests(testSize);
+    }
+
+    std::cout << "  Load test 10 (snapshot publication, 1 writer and readers): ";
+    {
+        int testSize = 10'000'000;
+        loadAtomicSharedPointerTests(testSize);
+    }
+
+    std::cout << "  Load test 11 (vector teardown with deferred releases): ";
+    {
+        int testSize = 10'000'000;
+        loadSharedPointerDeferredReleaseTests(testSize);
+    }
+
+    std::cout << "  Load test 12 (biased counting, mixed local and remote copies): ";
+    {
+        int testSize = 10'000'000;
+        loadBiasedCountingTests(testSize);
     }
     std::cout << "\n\n";
 }
 
-void LinkedListSharedPointerTests() {
-    std::cout << "Linked list shared pointer tests:\n\n";
+void LinkedListUniquePointerTests() {
+    std::cout << "Linked list unique pointer tests:\n\n";
 
     std::cout << "  Functional test 1 (pushing elements): ";
     {
         try {
-            LinkedListSharedPointer<int> list;
+            LinkedListUniquePointer<int> list;
             list.push_front(10);
             std::cout << (list.size() == 1 ? "Passed" : "Failed") << "\n";
         } catch (const std::exception &e) {
@@ -317,7 +756,7 @@ void LinkedListSharedPointerTests() {
     std::cout << "  Functional test 2 (push, pop elements and size()): ";
     {
         try {
-            LinkedListSharedPointer<int> list;
+            LinkedListUniquePointer<int> list;
             list.push_front(10);
             list.pop_front();
             std::cout << (list.size() == 0 ? "Passed" : "Failed") << "\n";
@@ -331,7 +770,7 @@ void LinkedListSharedPointerTests() {
     std::cout << "  Functional test 3 (null() function): ";
     {
         try {
-            LinkedListSharedPointer<int> list;
+            LinkedListUniquePointer<int> list;
             std::cout << (list.null() ? "Passed" : "Failed") << "\n";
         } catch (const std::exception &e) {
             std::cout << "Failed with exception: " << e.what() << "\n";
@@ -343,7 +782,7 @@ void LinkedListSharedPointerTests() {
     std::cout << "  Functional test 4 (clear() function): ";
     {
         try {
-            LinkedListSharedPointer<int> list;
+            LinkedListUniquePointer<int> list;
             list.push_front(10);
             list.push_front(20);
             list.clear();
@@ -355,16 +794,289 @@ void LinkedListSharedPointerTests() {
         }
     }
 
-    std::cout << "  Load test 1 (small): ";
-    {
-        int testSize = 1000;
-        loadLinkedListSharedPointerTests(testSize);
-    }
-
-    std::cout << "  Load test 2 (medium): ";
+    std::cout << "  Functional test 5 (pool allocator): ";
     {
-        int testSize = 100'000;
-        loadLinkedListSharedPointerTests(testSize);
+        try {
+            LinkedListUniquePointer<int, PoolAllocator> list;
+            for (int i = 0; i < 1000; ++i) {
+                list.push_front(i);
+            }
+            list.pop_front();
+            list.push_front(2000);
+            assert(list.get_front() == 2000);
+            list.clear();
+            std::cout << (list.size() == 0 && list.null() ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 6 (indexed list reuses popped slots): ";
+    {
+        try {
+            LinkedListIndexed<int> list;
+            list.push_front(10);
+            list.push_front(20);
+            list.pop_front();
+            list.push_front(30);
+            long long sum = 0;
+            list.for_each([&sum](int value) {
+                sum += value;
+            });
+            const LinkedListIndexed<int> &view = list;
+            assert(list.size() == 2 && view.get_front() == 30 && sum == 40);
+            list.clear();
+            std::cout << (list.size() == 0 && list.null() ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 7 (unrolled list across node boundaries): ";
+    {
+        try {
+            LinkedListUnrolled<int, 4> list;
+            for (int i = 0; i < 10; ++i) {
+                list.push_front(i);
+            }
+            for (int i = 0; i < 5; ++i) {
+                list.pop_front();
+            }
+            int expected = 4;
+            bool ordered = true;
+            list.for_each([&](int value) {
+                ordered = ordered && value == expected--;
+            });
+            assert(list.size() == 5 && list.get_front() == 4 && ordered);
+            list.clear();
+            std::cout << (list.size() == 0 && list.null() ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 8 (tagged list keeps per-node flags): ";
+    {
+        try {
+            LinkedListUniquePointer<long long, NewDeleteAllocator, TaggedLink> list;
+            static_assert(sizeof(NodeUniquePointer<long long, NewDeleteAllocator, TaggedLink>) == 16);
+
+            for (int i = 0; i < 5; ++i) {
+                list.push_front(i, i % 4);
+            }
+            list.pop_front();
+            list.set_front_flags(1);
+
+            std::vector<uintptr_t> flags;
+            list.for_each_flagged([&flags](long long, uintptr_t f) {
+                flags.push_back(f);
+            });
+            std::cout << (list.size() == 4 && list.get_front() == 3 && flags == std::vector<uintptr_t>{1, 2, 1, 0}
+                          ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Load test 1 (small): ";
+    {
+        int testSize = 1000;
+        loadLinkedListUniquePointerTests(testSize);
+    }
+
+    std::cout << "  Load test 2 (medium): ";
+    {
+        int testSize = 100'000;
+        loadLinkedListUniquePointerTests(testSize);
+    }
+
+    std::cout << "  Load test 3 (big): ";
+    {
+        int testSize = 10'000'000;
+        loadLinkedListUniquePointerTests(testSize);
+    }
+
+    std::cout << "  Load test 4 (malloc vs pool allocator, two rounds of push and clear): ";
+    {
+        int testSize = 10'000'000;
+        loadLinkedListPoolAllocatorTests(testSize);
+    }
+
+    std::cout << "  Load test 5 (construction and teardown): ";
+    {
+        int testSize = 10'000'000;
+        loadLinkedListTeardownTests(testSize);
+    }
+
+    std::cout << "  Load test 6 (indexed list, big): ";
+    {
+        int testSize = 10'000'000;
+        loadLinkedListIndexedTests(testSize);
+    }
+
+    std::cout << "  Load test 7 (unrolled lists, big): ";
+    {
+        int testSize = 10'000'000;
+        loadLinkedListUnrolledTests(testSize);
+    }
+
+    std::cout << "  Load test 8 (sequential scan, pointer lists vs indexed and unrolled lists): ";
+    {
+        int testSize = 10'000'000;
+        loadLinkedListTraversalTests(testSize);
+    }
+    std::cout << "\n\n";
+}
+
+void LinkedListSharedPointerTests() {
+    std::cout << "Linked list shared pointer tests:\n\n";
+
+    std::cout << "  Functional test 1 (pushing elements): ";
+    {
+        try {
+            LinkedListSharedPointer<int> list;
+            list.push_front(10);
+            std::cout << (list.size() == 1 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 2 (push, pop elements and size()): ";
+    {
+        try {
+            LinkedListSharedPointer<int> list;
+            list.push_front(10);
+            list.pop_front();
+            std::cout << (list.size() == 0 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 3 (null() function): ";
+    {
+        try {
+            LinkedListSharedPointer<int> list;
+            std::cout << (list.null() ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 4 (clear() function): ";
+    {
+        try {
+            LinkedListSharedPointer<int> list;
+            list.push_front(10);
+            list.push_front(20);
+            list.clear();
+            std::cout << (list.size() == 0 && list.null() ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 5 (teardown keeps shared tail alive): ";
+    {
+        try {
+            using Node = NodeSharedPointer<int>;
+
+            SharedPointer<Node> head(new Node(1));
+            head->next = SharedPointer<Node>(new Node(2));
+            head->next->next = SharedPointer<Node>(new Node(3));
+            SharedPointer<Node> tail = head->next;
+
+            head.reset();
+
+            std::cout << (tail.use_count() == 1 && tail->data == 2 && tail->next->data == 3 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 6 (concurrent stack from several threads): ";
+    {
+        try {
+            ConcurrentStack<int> stack;
+            std::vector<std::thread> threads;
+            std::atomic<long long> popped = 0;
+
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&stack, &popped]() {
+                    int value = 0;
+                    for (int i = 1; i <= 10'000; ++i) {
+                        stack.push_front(i);
+                        if (stack.pop_front(value)) {
+                            popped += value;
+                        }
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+
+            long long pushed = 4LL * 10'000 * 10'001 / 2;
+            std::cout << (popped == pushed && stack.null() && stack.size() == 0 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 7 (pool serves nodes and control blocks): ";
+    {
+        try {
+            LinkedListSharedPointer<int, PoolAllocator> list;
+            for (int i = 0; i < 1000; ++i) {
+                list.push_front(i);
+            }
+            list.clear();
+
+            startAllocationCounting();
+            for (int i = 0; i < 1000; ++i) {
+                list.push_front(i);
+            }
+            list.clear();
+            AllocationCounts counts = stopAllocationCounting();
+            std::cout << (counts.allocations == 0 && counts.deallocations == 0 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Load test 1 (small): ";
+    {
+        int testSize = 1000;
+        loadLinkedListSharedPointerTests(testSize);
+    }
+
+    std::cout << "  Load test 2 (medium): ";
+    {
+        int testSize = 100'000;
+        loadLinkedListSharedPointerTests(testSize);
     }
 
     std::cout << "  Load test 3 (big): ";
@@ -372,6 +1084,286 @@ void LinkedListSharedPointerTests() {
         int testSize = 10'000'000;
         loadLinkedListSharedPointerTests(testSize);
     }
+
+    std::cout << "  Load test 4 (allocations per push_front): ";
+    {
+        int testSize = 100'000;
+        loadLinkedListSharedPointerAllocationTests(testSize);
+    }
+
+    std::cout << "  Load test 5 (concurrent stack vs mutex-protected list, 1 to all cores): ";
+    {
+        int testSize = 10'000'000;
+        loadConcurrentStackTests(testSize);
+    }
+    std::cout << "\n\n";
+}
+
+void WeakPointerTests() {
+    std::cout << "Weak pointer tests:\n\n";
+
+    std::cout << "  Functional test 1 (lock while shared): ";
+    {
+        try {
+            SharedPointer<int> p1 = MakeShared<int>(10);
+            WeakPointer<int> w1(p1);
+            SharedPointer<int> p2 = w1.lock();
+
+            assert(!w1.expired());
+            assert(*p2 == 10 && p1.use_count() == 2);
+
+            std::cout << "Passed\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 2 (expiration): ";
+    {
+        try {
+            WeakPointer<int> w1;
+            {
+                SharedPointer<int> p1(new int(20));
+                w1 = p1;
+                assert(w1.use_count() == 1);
+            }
+            WeakPointer<int> w2 = w1;
+
+            assert(w1.expired() && w2.expired());
+            assert(w1.lock().null());
+
+            std::cout << "Passed\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 3 (back-links do not leak): ";
+    {
+        try {
+            struct Node {
+                int &alive;
+                SharedPointer<Node> next;
+                WeakPointer<Node> previous;
+
+                explicit Node(int &counter) : alive(counter) {
+                    ++alive;
+                }
+
+                ~Node() {
+                    --alive;
+                }
+            };
+
+            int alive = 0;
+            {
+                SharedPointer<Node> first = MakeShared<Node>(alive);
+                SharedPointer<Node> second = MakeShared<Node>(alive);
+                first->next = second;
+                second->previous = first;
+
+                assert(second->previous.lock().get() == first.get());
+            }
+
+            std::cout << (alive == 0 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Load test 1 (lock, small): ";
+    {
+        int testSize = 1000;
+        loadWeakPointerLockTests(testSize);
+    }
+
+    std::cout << "  Load test 2 (lock, medium): ";
+    {
+        int testSize = 100'000;
+        loadWeakPointerLockTests(testSize);
+    }
+
+    std::cout << "  Load test 3 (lock, big): ";
+    {
+        int testSize = 10'000'000;
+        loadWeakPointerLockTests(testSize);
+    }
+
+    std::cout << "  Load test 4 (release with only weak references): ";
+    {
+        int testSize = 100'000;
+        loadWeakPointerReleaseTests(testSize);
+    }
+    std::cout << "\n\n";
+}
+
+// Counted through its own hooks rather than IntrusiveCounted.
+struct ExternallyCounted {
+    int references = 0;
+    int &alive;
+
+    explicit ExternallyCounted(int &counter) : alive(counter) {
+        ++alive;
+    }
+
+    ~ExternallyCounted() {
+        --alive;
+    }
+};
+
+void intrusiveRetain(ExternallyCounted *object) {
+    ++object->references;
+}
+
+void intrusiveRelease(ExternallyCounted *object) {
+    if (--object->references == 0) {
+        delete object;
+    }
+}
+
+void IntrusivePointerTests() {
+    std::cout << "Intrusive pointer tests:\n\n";
+
+    std::cout << "  Functional test 1 (copying and use_count()): ";
+    {
+        try {
+            struct Value : IntrusiveCounted<Value> {
+                int value;
+                explicit Value(int v) : value(v) {}
+            };
+
+            IntrusivePointer<Value> p1 = MakeIntrusive<Value>(10);
+            IntrusivePointer<Value> p2 = p1;
+            assert(p1.use_count() == 2 && p2->value == 10);
+
+            p2.reset();
+            assert(p1.use_count() == 1 && p2.null());
+
+            IntrusivePointer<Value> p3(p1.get());
+            std::cout << (p1.use_count() == 2 && p3.get() == p1.get() ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 2 (custom hooks, destruction on last release): ";
+    {
+        try {
+            int alive = 0;
+            {
+                IntrusivePointer<ExternallyCounted> p1(new ExternallyCounted(alive));
+                IntrusivePointer<ExternallyCounted> p2 = p1;
+                IntrusivePointer<ExternallyCounted> p3 = std::move(p2);
+                assert(p1->references == 2 && p2.null() && alive == 1);
+            }
+            std::cout << (alive == 0 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 3 (subtipization, atomic counts): ";
+    {
+        try {
+            struct Base : IntrusiveCounted<Base, AtomicCounting> {
+                int value = 1;
+
+                // The last release deletes through Base.
+                virtual ~Base() = default;
+            };
+            struct Derived : Base {
+                Derived() {
+                    value = 2;
+                }
+            };
+
+            IntrusivePointer<Derived> derived(new Derived());
+            IntrusivePointer<Base> base = derived;
+            IntrusivePointer<Base> moved = std::move(derived);
+            std::cout << (base->value == 2 && base.use_count() == 2 && derived.null() ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 4 (intrusive list push, pop and clear()): ";
+    {
+        try {
+            LinkedListIntrusivePointer<int> list;
+            list.push_front(10);
+            list.push_front(20);
+            list.pop_front();
+            bool front = list.size() == 1 && list.get_front() == 10;
+            list.clear();
+            std::cout << (front && list.null() ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Functional test 5 (teardown keeps shared tail alive): ";
+    {
+        try {
+            using Node = NodeIntrusivePointer<int>;
+
+            IntrusivePointer<Node> head(new Node(1));
+            head->next = IntrusivePointer<Node>(new Node(2));
+            head->next->next = IntrusivePointer<Node>(new Node(3));
+            IntrusivePointer<Node> tail = head->next;
+
+            head.reset();
+
+            std::cout << (tail.use_count() == 1 && tail->data == 2 && tail->next->data == 3 ? "Passed" : "Failed") << "\n";
+        } catch (const std::exception &e) {
+            std::cout << "Failed with exception: " << e.what() << "\n";
+        } catch (...) {
+            std::cout << "Failed with unknown exception\n";
+        }
+    }
+
+    std::cout << "  Load test 1 (small): ";
+    {
+        int testSize = 1000;
+        loadIntrusivePointerTests(testSize);
+    }
+
+    std::cout << "  Load test 2 (medium): ";
+    {
+        int testSize = 100'000;
+        loadIntrusivePointerTests(testSize);
+    }
+
+    std::cout << "  Load test 3 (big): ";
+    {
+        int testSize = 10'000'000;
+        loadIntrusivePointerTests(testSize);
+    }
+
+    std::cout << "  Load test 4 (list, medium): ";
+    {
+        int testSize = 100'000;
+        loadLinkedListIntrusivePointerTests(testSize);
+    }
+
+    std::cout << "  Load test 5 (list, big): ";
+    {
+        int testSize = 10'000'000;
+        loadLinkedListIntrusivePointerTests(testSize);
+    }
     std::cout << "\n\n";
 }
 
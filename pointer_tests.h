@@ -9,3 +9,5 @@ void LinkedListUniquePointerTests();
 void SharedPointerTests();
 void StdSharedPointerTests();
 void LinkedListSharedPointerTests();
+void WeakPointerTests();
+void IntrusivePointerTests();
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Hands out fixed-size blocks from large contiguous chunks and keeps freed
+// blocks on an intrusive free list. Not thread-safe.
+template<size_t BlockSize, size_t BlockAlignment, size_t ChunkBytes = 1 << 20>
+class FixedSizePool {
+
+private:
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    static constexpr size_t alignment = BlockAlignment > alignof(FreeBlock) ? BlockAlignment : alignof(FreeBlock);
+    static constexpr size_t slotSize = ((BlockSize > sizeof(FreeBlock) ? BlockSize : sizeof(FreeBlock)) + alignment - 1)
+                                       / alignment * alignment;
+    static constexpr size_t slotsPerChunk = ChunkBytes / slotSize > 0 ? ChunkBytes / slotSize : 1;
+
+    std::vector<void *> chunks;
+    FreeBlock *freeList;
+    char *cursor;
+    char *chunkEnd;
+    size_t liveBlocks;
+
+    void grow() {
+        void *chunk = ::operator new(slotsPerChunk * slotSize, std::align_val_t(alignment));
+        chunks.push_back(chunk);
+        cursor = static_cast<char *>(chunk);
+        chunkEnd = cursor + slotsPerChunk * slotSize;
+    }
+
+public:
+
+    FixedSizePool() : freeList(nullptr), cursor(nullptr), chunkEnd(nullptr), liveBlocks(0) {}
+
+    FixedSizePool(const FixedSizePool &) = delete;
+    FixedSizePool &operator=(const FixedSizePool &) = delete;
+
+    ~FixedSizePool() {
+        for (void *chunk : chunks) {
+            ::operator delete(chunk, std::align_val_t(alignment));
+        }
+    }
+
+    void *allocate() {
+        ++liveBlocks;
+        if (freeList) {
+            FreeBlock *block = freeList;
+            freeList = block->next;
+            return block;
+        }
+        if (cursor == chunkEnd) {
+            grow();
+        }
+        void *block = cursor;
+        cursor += slotSize;
+        return block;
+    }
+
+    void deallocate(void *p) {
+        --liveBlocks;
+        FreeBlock *block = static_cast<FreeBlock *>(p);
+        block->next = freeList;
+        freeList = block;
+    }
+
+    // Returns every chunk to the system once no block is in use.
+    bool release() {
+        if (liveBlocks != 0) {
+            return false;
+        }
+        for (void *chunk : chunks) {
+            ::operator delete(chunk, std::align_val_t(alignment));
+        }
+        chunks.clear();
+        freeList = nullptr;
+        cursor = nullptr;
+        chunkEnd = nullptr;
+        return true;
+    }
+
+    size_t chunkCount() const {
+        return chunks.size();
+    }
+};
+
+template<size_t BlockSize, size_t BlockAlignment>
+inline FixedSizePool<BlockSize, BlockAlignment> fixedSizePoolInstance;
+
+struct NewDeleteAllocator {
+
+    template<typename U>
+    static void *allocate() {
+        return ::operator new(sizeof(U));
+    }
+
+    template<typename U>
+    static void deallocate(void *p) {
+        ::operator delete(p, sizeof(U));
+    }
+};
+
+struct PoolAllocator {
+
+    template<typename U>
+    static FixedSizePool<sizeof(U), alignof(U)> &pool() {
+        return fixedSizePoolInstance<sizeof(U), alignof(U)>;
+    }
+
+    template<typename U>
+    static void *allocate() {
+        return pool<U>().allocate();
+    }
+
+    template<typename U>
+    static void deallocate(void *p) {
+        pool<U>().deallocate(p);
+    }
+
+    template<typename U>
+    static bool release() {
+        return pool<U>().release();
+    }
+};
+
+// Standard allocator interface over a static allocator such as PoolAllocator,
+// for code that takes allocators by value, e.g. SharedPointer control blocks.
+// Serves one object at a time.
+template<typename T, typename Allocator>
+class StaticAllocatorAdapter {
+
+public:
+
+    using value_type = T;
+
+    StaticAllocatorAdapter() = default;
+
+    template<typename U>
+    StaticAllocatorAdapter(const StaticAllocatorAdapter<U, Allocator> &) {}
+
+    T *allocate(size_t n) {
+        if (n != 1) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T *>(Allocator::template allocate<T>());
+    }
+
+    void deallocate(T *p, size_t) {
+        Allocator::template deallocate<T>(p);
+    }
+
+    template<typename U>
+    bool operator==(const StaticAllocatorAdapter<U, Allocator> &) const {
+        return true;
+    }
+};
+
+template<typename T>
+struct PoolDelete {
+
+    void operator()(T *p) const {
+        p->~T();
+        PoolAllocator::deallocate<T>(p);
+    }
+};
+
+// Hands out memory by bumping an offset in one buffer; deallocation is a
+// no-op and reset() reclaims everything at once.
+class BumpArena {
+
+private:
+
+    char *buffer;
+    size_t capacity;
+    size_t offset;
+
+public:
+
+    explicit BumpArena(size_t bytes) : buffer(static_cast<char *>(::operator new(bytes))), capacity(bytes), offset(0) {}
+
+    BumpArena(const BumpArena &) = delete;
+    BumpArena &operator=(const BumpArena &) = delete;
+
+    ~BumpArena() {
+        ::operator delete(buffer);
+    }
+
+    void *allocate(size_t bytes, size_t alignment) {
+        size_t start = (offset + alignment - 1) / alignment * alignment;
+        if (start + bytes > capacity) {
+            throw std::bad_alloc();
+        }
+        offset = start + bytes;
+        return buffer + start;
+    }
+
+    void reset() {
+        offset = 0;
+    }
+
+    size_t used() const {
+        return offset;
+    }
+};
+
+template<typename T>
+class BumpAllocator {
+
+public:
+
+    using value_type = T;
+
+    BumpArena *arena;
+
+    explicit BumpAllocator(BumpArena &a) : arena(&a) {}
+
+    template<typename U>
+    BumpAllocator(const BumpAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, size_t) {}
+
+    template<typename U>
+    bool operator==(const BumpAllocator<U> &other) const {
+        return arena == other.arena;
+    }
+};
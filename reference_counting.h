@@ -0,0 +1,370 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef SHARED_POINTER_STATISTICS
+struct SharedPointerStatistics {
+
+    inline static std::atomic<size_t> increments = 0;
+    inline static std::atomic<size_t> decrements = 0;
+
+    static void reset() {
+        increments = 0;
+        decrements = 0;
+    }
+};
+#endif
+
+// Single-threaded counting: plain increments, no synchronisation.
+struct NonAtomicCounting {
+
+    using Counter = size_t;
+
+    static void increment(Counter &counter) {
+        ++counter;
+    }
+
+    static bool decrement(Counter &counter) {
+        return --counter == 0;
+    }
+
+    static bool incrementIfNonZero(Counter &counter) {
+        if (counter == 0) {
+            return false;
+        }
+        ++counter;
+        return true;
+    }
+
+    static size_t load(const Counter &counter) {
+        return counter;
+    }
+};
+
+// Thread-safe counting: a new reference is always made from an existing one,
+// so increments can be relaxed; the last decrement synchronises with all
+// earlier ones before the object is destroyed.
+struct AtomicCounting {
+
+    using Counter = std::atomic<size_t>;
+
+    static void increment(Counter &counter) {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static bool decrement(Counter &counter) {
+        if (counter.fetch_sub(1, std::memory_order_release) == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return true;
+        }
+        return false;
+    }
+
+    static bool incrementIfNonZero(Counter &counter) {
+        size_t current = counter.load(std::memory_order_relaxed);
+        while (current != 0) {
+            if (counter.compare_exchange_weak(current, current + 1, std::memory_order_acquire,
+                                              std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static size_t load(const Counter &counter) {
+        return counter.load(std::memory_order_relaxed);
+    }
+};
+
+// Biased counting: the thread that creates the object counts its own references
+// in a plain local count; every other thread uses an atomic shared count. When
+// the local count drains, the owner merges the two and the object falls back to
+// shared counting. A non-owner whose release would take the shared count below
+// zero hands that release to the owner instead, because the reference it drops
+// is still in the owner's local count. The owner applies such releases in
+// processQueuedReleases() or when it exits; after it exits, other threads merge
+// on its behalf. Objects handed to other threads are therefore only destroyed
+// once their owner calls processQueuedReleases() or exits, so a long-lived
+// thread that gives objects away must call it periodically. Needs the control
+// block on release, so it only works with SharedPointer, and weak counts stay
+// plain atomic.
+struct BiasedCounting {
+
+    struct Owner;
+
+    struct Counter {
+
+        std::atomic<Owner *> owner;
+        size_t local;
+        // Shared count times two, plus one once merged.
+        std::atomic<size_t> shared;
+
+        explicit Counter(size_t initial) : owner(attach()), local(initial), shared(0) {}
+
+        ~Counter() {
+            // Only a block whose construction failed still has an owner here.
+            if (Owner *current = owner.load(std::memory_order_relaxed)) {
+                detach(current);
+            }
+        }
+
+        Counter(const Counter &) = delete;
+        Counter &operator=(const Counter &) = delete;
+    };
+
+    struct QueuedRelease {
+        Counter *counter;
+        void *block;
+        void (*destroy)(void *);
+    };
+
+    struct Owner {
+
+        std::mutex mutex;
+        std::vector<QueuedRelease> queue;
+        bool exited = false;
+        // The thread until it exits, plus one per counter still biased towards it.
+        std::atomic<size_t> references = 1;
+    };
+
+private:
+
+    static constexpr size_t merged = 1;
+    static constexpr size_t unit = 2;
+
+    inline static constinit thread_local Owner *threadOwner = nullptr;
+
+    // An owner record goes back to the free list once its thread has exited and
+    // no counter is biased towards it, and the next new thread reuses it. Records
+    // are never returned to the heap: a non-owner that read a counter's owner
+    // just before the counter merged may still lock that record's mutex.
+    struct OwnerRegistry {
+
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Owner>> owners;
+        std::vector<Owner *> free;
+    };
+
+    static OwnerRegistry &registry() {
+        static OwnerRegistry instance;
+        return instance;
+    }
+
+    struct ThreadExit {
+
+        ~ThreadExit() {
+            Owner *owner = threadOwner;
+            std::vector<QueuedRelease> queue;
+            {
+                std::lock_guard<std::mutex> lock(owner->mutex);
+                owner->exited = true;
+                queue.swap(owner->queue);
+            }
+            for (const QueuedRelease &release : queue) {
+                complete(release, owner);
+            }
+            threadOwner = nullptr;
+            detach(owner);
+        }
+    };
+
+    static Owner *currentOwner() {
+        if (!threadOwner) {
+            Owner *owner = nullptr;
+            {
+                OwnerRegistry &owners = registry();
+                std::lock_guard<std::mutex> lock(owners.mutex);
+                if (owners.free.empty()) {
+                    owners.owners.push_back(std::make_unique<Owner>());
+                    owner = owners.owners.back().get();
+                } else {
+                    owner = owners.free.back();
+                    owners.free.pop_back();
+                    std::lock_guard<std::mutex> ownerLock(owner->mutex);
+                    owner->exited = false;
+                    owner->references.store(1, std::memory_order_relaxed);
+                }
+            }
+            threadOwner = owner;
+            thread_local ThreadExit threadExit;
+            (void) threadExit;
+        }
+        return threadOwner;
+    }
+
+    static Owner *attach() {
+        Owner *owner = currentOwner();
+        owner->references.fetch_add(1, std::memory_order_relaxed);
+        return owner;
+    }
+
+    static void detach(Owner *owner) {
+        if (owner->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            OwnerRegistry &owners = registry();
+            std::lock_guard<std::mutex> lock(owners.mutex);
+            owners.free.push_back(owner);
+        }
+    }
+
+    static bool owned(const Counter &counter) {
+        Owner *owner = counter.owner.load(std::memory_order_relaxed);
+        return owner == threadOwner && owner;
+    }
+
+    // Folds the local count into the shared one; only one thread wins for a given owner.
+    static size_t unbias(Counter &counter, Owner *owner) {
+        if (!counter.owner.compare_exchange_strong(owner, nullptr, std::memory_order_acq_rel)) {
+            return 0;
+        }
+        size_t local = counter.local;
+        counter.local = 0;
+        size_t previous = counter.shared.fetch_add(local * unit + merged, std::memory_order_acq_rel);
+        detach(owner);
+        return previous;
+    }
+
+    static bool decrementMerged(Counter &counter) {
+        if (counter.shared.fetch_sub(unit, std::memory_order_release) == unit + merged) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return true;
+        }
+        return false;
+    }
+
+    static void complete(const QueuedRelease &release, Owner *owner) {
+        unbias(*release.counter, owner);
+        if (decrementMerged(*release.counter)) {
+            release.destroy(release.block);
+        }
+    }
+
+    static bool enqueue(Owner *owner, const QueuedRelease &release) {
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        if (owner->exited) {
+            return false;
+        }
+        owner->queue.push_back(release);
+        return true;
+    }
+
+    // The owner dropped its last local reference.
+    static bool mergeLocal(Counter &counter) {
+        Owner *owner = counter.owner.load(std::memory_order_relaxed);
+        counter.owner.store(nullptr, std::memory_order_relaxed);
+        bool last = counter.shared.fetch_add(merged, std::memory_order_acq_rel) == 0;
+        detach(owner);
+        return last;
+    }
+
+    // Kept out of decrement so that the owner's path stays small enough to inline.
+    static bool decrementShared(Counter &counter, void *block, void (*destroy)(void *)) {
+        size_t word = counter.shared.load(std::memory_order_relaxed);
+        while (true) {
+            if (word & merged) {
+                return decrementMerged(counter);
+            }
+            if (word == 0) {
+                // The reference being dropped is in the owner's local count.
+                Owner *owner = counter.owner.load(std::memory_order_acquire);
+                if (owner) {
+                    if (enqueue(owner, QueuedRelease{&counter, block, destroy})) {
+                        return false;
+                    }
+                    unbias(counter, owner);
+                } else {
+                    // Another thread is merging right now.
+                    std::this_thread::yield();
+                }
+                word = counter.shared.load(std::memory_order_acquire);
+                continue;
+            }
+            if (counter.shared.compare_exchange_weak(word, word - unit, std::memory_order_release,
+                                                     std::memory_order_relaxed)) {
+                return false;
+            }
+        }
+    }
+
+public:
+
+    static void increment(Counter &counter) {
+        if (owned(counter)) {
+            ++counter.local;
+        } else {
+            counter.shared.fetch_add(unit, std::memory_order_relaxed);
+        }
+    }
+
+    template<typename Block>
+    static bool decrement(Counter &counter, Block *block) {
+        if (owned(counter)) {
+            return --counter.local == 0 && mergeLocal(counter);
+        }
+        return decrementShared(counter, block, [](void *p) {
+            static_cast<Block *>(p)->destroy();
+        });
+    }
+
+    static bool incrementIfNonZero(Counter &counter) {
+        if (owned(counter)) {
+            ++counter.local;
+            return true;
+        }
+        size_t word = counter.shared.load(std::memory_order_relaxed);
+        while (word != merged) {
+            if (counter.shared.compare_exchange_weak(word, word + unit, std::memory_order_acquire,
+                                                     std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Exact on the owning thread and once merged; elsewhere a lower bound.
+    static size_t load(const Counter &counter) {
+        size_t word = counter.shared.load(std::memory_order_relaxed);
+        if (owned(counter)) {
+            return counter.local + word / unit;
+        }
+        return word / unit + (word & merged ? 0 : 1);
+    }
+
+    // Applies the releases other threads handed to the calling thread.
+    static void processQueuedReleases() {
+        Owner *owner = threadOwner;
+        if (!owner) {
+            return;
+        }
+        std::vector<QueuedRelease> queue;
+        {
+            std::lock_guard<std::mutex> lock(owner->mutex);
+            queue.swap(owner->queue);
+        }
+        for (const QueuedRelease &release : queue) {
+            complete(release, owner);
+        }
+    }
+
+    // Owner records allocated so far; records of finished threads are reused.
+    static size_t ownerRecords() {
+        OwnerRegistry &owners = registry();
+        std::lock_guard<std::mutex> lock(owners.mutex);
+        return owners.owners.size();
+    }
+};
+
+// Policy used for the weak count of a control block.
+template<typename Counting>
+struct WeakCounting {
+    using type = Counting;
+};
+
+template<>
+struct WeakCounting<BiasedCounting> {
+    using type = AtomicCounting;
+};
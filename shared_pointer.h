@@ -1,31 +1,393 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
-template<typename T>
+#include "reference_counting.h"
+
+template<typename T, typename Counting>
+class WeakPointer;
+
+// Counting policy whose SharedPointers queue their releases while a
+// DeferredReleaseScope is open; with any other policy a release is applied at
+// once and never looks at the scope.
+template<typename Counting>
+struct DeferredCounting : Counting {};
+
+template<typename Counting>
+struct WeakCounting<DeferredCounting<Counting>> : WeakCounting<Counting> {};
+
+template<typename Counting>
+inline constexpr bool isDeferredCounting = false;
+
+template<typename Counting>
+inline constexpr bool isDeferredCounting<DeferredCounting<Counting>> = true;
+
+// Lets one queue hold deferred releases of control blocks of every counting policy.
+class DeferredReleaseTarget {
+
+public:
+
+    virtual void releaseDeferred() = 0;
+
+protected:
+
+    ~DeferredReleaseTarget() = default;
+};
+
+template<typename Counting>
+class SharedControlBlock : public DeferredReleaseTarget {
+
+public:
+
+    using Weak = typename WeakCounting<Counting>::type;
+
+    typename Counting::Counter referenceCount;
+    // Weak references plus one for the whole group of strong references.
+    typename Weak::Counter weakCount;
+
+    SharedControlBlock() : referenceCount(1), weakCount(1) {}
+
+    void retain() {
+#ifdef SHARED_POINTER_STATISTICS
+        SharedPointerStatistics::increments.fetch_add(1, std::memory_order_relaxed);
+#endif
+        Counting::increment(referenceCount);
+    }
+
+    bool release() {
+#ifdef SHARED_POINTER_STATISTICS
+        SharedPointerStatistics::decrements.fetch_add(1, std::memory_order_relaxed);
+#endif
+        if constexpr (requires { Counting::decrement(referenceCount, this); }) {
+            return Counting::decrement(referenceCount, this);
+        } else {
+            return Counting::decrement(referenceCount);
+        }
+    }
+
+    bool retainIfAlive() {
+        return Counting::incrementIfNonZero(referenceCount);
+    }
+
+    void retainWeak() {
+        Weak::increment(weakCount);
+    }
+
+    void releaseWeak() {
+        if (Weak::decrement(weakCount)) {
+            destroyBlock();
+        }
+    }
+
+    size_t count() const {
+        return Counting::load(referenceCount);
+    }
+
+    void destroy() {
+        destroyObject();
+        releaseWeak();
+    }
+
+    void releaseDeferred() override {
+        if (release()) {
+            destroy();
+        }
+    }
+
+    SharedControlBlock(const SharedControlBlock &) = delete;
+    SharedControlBlock &operator=(const SharedControlBlock &) = delete;
+
+    virtual ~SharedControlBlock() = default;
+
+    virtual void destroyObject() = 0;
+    virtual void destroyBlock() = 0;
+};
+
+// Non-zero while a DeferredReleaseScope is open on this thread.
+inline thread_local size_t deferredReleaseDepth = 0;
+
+// Releases queued by DeferredCounting pointers while a DeferredReleaseScope is
+// open. A flush applies them sorted by control block address, prefetching a few
+// blocks ahead, instead of missing the cache once per destroyed pointer.
+class DeferredRelease {
+
+private:
+
+    static constexpr size_t batchSize = 4096;
+    static constexpr size_t prefetchDistance = 8;
+
+    inline static thread_local std::vector<DeferredReleaseTarget *> pending;
+
+public:
+
+    static void defer(DeferredReleaseTarget *block) {
+        pending.push_back(block);
+        if (pending.size() >= batchSize) {
+            flush();
+        }
+    }
+
+    static void flush() {
+        std::vector<DeferredReleaseTarget *> batch;
+        while (!pending.empty()) {
+            // Destroyed objects may release further pointers, which queue up again in pending.
+            batch.swap(pending);
+            if (!std::is_sorted(batch.begin(), batch.end())) {
+                std::sort(batch.begin(), batch.end());
+            }
+            for (size_t i = 0; i < batch.size(); ++i) {
+#if defined(__GNUC__) || defined(__clang__)
+                if (i + prefetchDistance < batch.size()) {
+                    __builtin_prefetch(batch[i + prefetchDistance], 1);
+                }
+#endif
+                batch[i]->releaseDeferred();
+            }
+            batch.clear();
+        }
+        if (pending.capacity() < batch.capacity()) {
+            pending.swap(batch);
+        }
+    }
+};
+
+// Applies every release queued on this thread so far.
+inline void flushDeferredReleases() {
+    DeferredRelease::flush();
+}
+
+// While alive, DeferredCounting pointers destroyed or reassigned on this thread
+// queue their release instead of applying it; the outermost scope flushes on
+// exit. Objects therefore live until the next flush, in batches of up to 4096
+// releases.
+class DeferredReleaseScope {
+
+public:
+
+    DeferredReleaseScope() {
+        ++deferredReleaseDepth;
+    }
+
+    DeferredReleaseScope(const DeferredReleaseScope &) = delete;
+    DeferredReleaseScope &operator=(const DeferredReleaseScope &) = delete;
+
+    ~DeferredReleaseScope() {
+        if (--deferredReleaseDepth == 0) {
+            flushDeferredReleases();
+        }
+    }
+};
+
+template<typename Block, typename Allocator, typename... Args>
+Block *allocateControlBlock(const Allocator &allocator, Args &&... args) {
+    using BlockAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Block>;
+    using Traits = std::allocator_traits<BlockAllocator>;
+
+    BlockAllocator blockAllocator(allocator);
+    Block *block = Traits::allocate(blockAllocator, 1);
+    try {
+        return ::new(static_cast<void *>(block)) Block(std::forward<Args>(args)...);
+    } catch (...) {
+        Traits::deallocate(blockAllocator, block, 1);
+        throw;
+    }
+}
+
+template<typename Block, typename Allocator>
+void deallocateControlBlock(Block *block, const Allocator &allocator) {
+    using BlockAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Block>;
+    using Traits = std::allocator_traits<BlockAllocator>;
+
+    BlockAllocator blockAllocator(allocator);
+    block->~Block();
+    Traits::deallocate(blockAllocator, block, 1);
+}
+
+template<typename T, typename Counting>
+class SharedControlBlockPointer : public SharedControlBlock<Counting> {
+
+private:
+
+    T *pointer;
+
+public:
+
+    explicit SharedControlBlockPointer(T *p) : pointer(p) {}
+
+    void destroyObject() override {
+        delete pointer;
+    }
+
+    void destroyBlock() override {
+        delete this;
+    }
+};
+
+template<typename T, typename Counting>
+class SharedControlBlockArray : public SharedControlBlock<Counting> {
+
+private:
+
+    T *pointer;
+
+public:
+
+    explicit SharedControlBlockArray(T *p) : pointer(p) {}
+
+    void destroyObject() override {
+        delete[] pointer;
+    }
+
+    void destroyBlock() override {
+        delete this;
+    }
+};
+
+template<typename T, typename Deleter, typename Allocator, typename Counting>
+class SharedControlBlockDeleter : public SharedControlBlock<Counting> {
+
+private:
+
+    T *pointer;
+    Deleter deleter;
+    Allocator allocator;
+
+public:
+
+    SharedControlBlockDeleter(T *p, Deleter d, const Allocator &a) : pointer(p), deleter(std::move(d)), allocator(a) {}
+
+    void destroyObject() override {
+        deleter(pointer);
+    }
+
+    void destroyBlock() override {
+        deallocateControlBlock(this, allocator);
+    }
+};
+
+// Object and counter share one allocation, see MakeShared.
+template<typename T, typename Counting>
+class SharedControlBlockInplace : public SharedControlBlock<Counting> {
+
+private:
+
+    alignas(T) unsigned char storage[sizeof(T)];
+
+public:
+
+    template<typename... Args>
+    explicit SharedControlBlockInplace(Args &&... args) {
+        ::new(static_cast<void *>(storage)) T(std::forward<Args>(args)...);
+    }
+
+    T *get() {
+        return std::launder(reinterpret_cast<T *>(storage));
+    }
+
+    void destroyObject() override {
+        get()->~T();
+    }
+
+    void destroyBlock() override {
+        delete this;
+    }
+};
+
+// Same as above, but the block comes from the caller's allocator, see AllocateShared.
+template<typename T, typename Allocator, typename Counting>
+class SharedControlBlockInplaceAllocated : public SharedControlBlockInplace<T, Counting> {
+
+private:
+
+    Allocator allocator;
+
+public:
+
+    template<typename... Args>
+    explicit SharedControlBlockInplaceAllocated(const Allocator &a, Args &&... args)
+            : SharedControlBlockInplace<T, Counting>(std::forward<Args>(args)...), allocator(a) {}
+
+    void destroyBlock() override {
+        deallocateControlBlock(this, allocator);
+    }
+};
+
+
+template<typename T, typename Counting = NonAtomicCounting>
 class SharedPointer {
 
 private:
 
+    using ControlBlock = SharedControlBlock<Counting>;
+
     T* pointer;
-    size_t* referenceCount;
+    ControlBlock* controlBlock;
 
     void clean() {
-        if (referenceCount && --(*referenceCount) == 0) {
-            delete pointer;
-            delete referenceCount;
+        if (!controlBlock) {
+            return;
+        }
+        if constexpr (isDeferredCounting<Counting>) {
+            if (deferredReleaseDepth) {
+                DeferredRelease::defer(controlBlock);
+                return;
+            }
+        }
+        if (controlBlock->release()) {
+            controlBlock->destroy();
         }
     }
 
+    template<typename U, typename C, typename... Args>
+    friend SharedPointer<U, C> MakeShared(Args&&... args);
+
+    template<typename U, typename C, typename A, typename... Args>
+    friend SharedPointer<U, C> AllocateShared(const A& allocator, Args&&... args);
+
+    template<typename U, typename C>
+    friend class SharedPointer;
+
+    template<typename U, typename C>
+    friend class WeakPointer;
+
 public:
 
-    explicit SharedPointer(T* p = nullptr) : pointer(p), referenceCount(new size_t(1)) {}
+    explicit SharedPointer(T* p = nullptr) : pointer(p), controlBlock(nullptr) {
+        if (p) {
+            try {
+                controlBlock = new SharedControlBlockPointer<T, Counting>(p);
+            } catch (...) {
+                delete p;
+                throw;
+            }
+        }
+    }
+
+    template<typename Deleter, typename Allocator = std::allocator<T>>
+    SharedPointer(T* p, Deleter d, const Allocator& allocator = Allocator())
+    requires std::is_invocable_v<Deleter&, T*>
+            : pointer(p), controlBlock(nullptr) {
+        if (p) {
+            try {
+                controlBlock = allocateControlBlock<SharedControlBlockDeleter<T, Deleter, Allocator, Counting>>(
+                        allocator, p, std::move(d), allocator);
+            } catch (...) {
+                d(p);
+                throw;
+            }
+        }
+    }
 
     SharedPointer(const SharedPointer& other)
-            : pointer(other.pointer), referenceCount(other.referenceCount) {
-        if (referenceCount) {
-            ++(*referenceCount);
+            : pointer(other.pointer), controlBlock(other.controlBlock) {
+        if (controlBlock) {
+            controlBlock->retain();
         }
     }
 
@@ -33,14 +395,52 @@ public:
         if (this != &other) {
             clean();
             pointer = other.pointer;
-            referenceCount = other.referenceCount;
-            if (referenceCount) {
-                ++(*referenceCount);
+            controlBlock = other.controlBlock;
+            if (controlBlock) {
+                controlBlock->retain();
             }
         }
         return *this;
     }
 
+    SharedPointer(SharedPointer&& other) noexcept
+            : pointer(other.pointer), controlBlock(other.controlBlock) {
+        other.pointer = nullptr;
+        other.controlBlock = nullptr;
+    }
+
+    SharedPointer& operator=(SharedPointer&& other) noexcept {
+        T* p = other.pointer;
+        ControlBlock* block = other.controlBlock;
+        other.pointer = nullptr;
+        other.controlBlock = nullptr;
+        clean();
+        pointer = p;
+        controlBlock = block;
+        return *this;
+    }
+
+    template<typename U>
+    SharedPointer(SharedPointer<U, Counting>&& other) noexcept
+    requires std::is_convertible_v<U*, T*>
+            : pointer(static_cast<T*>(other.pointer)), controlBlock(other.controlBlock) {
+        other.pointer = nullptr;
+        other.controlBlock = nullptr;
+    }
+
+    template<typename U>
+    SharedPointer& operator=(SharedPointer<U, Counting>&& other) noexcept
+    requires std::is_convertible_v<U*, T*> {
+        T* p = static_cast<T*>(other.pointer);
+        ControlBlock* block = other.controlBlock;
+        other.pointer = nullptr;
+        other.controlBlock = nullptr;
+        clean();
+        pointer = p;
+        controlBlock = block;
+        return *this;
+    }
+
     ~SharedPointer() {
         clean();
     }
@@ -49,8 +449,8 @@ public:
         return pointer;
     }
 
-    size_t* use_count_ptr() const {
-        return referenceCount;
+    ControlBlock* control_block() const {
+        return controlBlock;
     }
 
     T& operator*() const {
@@ -62,13 +462,12 @@ public:
     }
 
     size_t use_count() const {
-        return referenceCount ? *referenceCount : 0;
+        return controlBlock ? controlBlock->count() : 0;
     }
 
+    // Builds the new block first, so a failed allocation leaves this pointer untouched.
     void reset(T* p = nullptr) {
-        clean();
-        pointer = p;
-        referenceCount = new size_t(1);
+        *this = SharedPointer(p);
     }
 
     bool null() const {
@@ -76,43 +475,80 @@ public:
     }
 
     template<typename U>
-    static SharedPointer<T> static_pointer_cast(const SharedPointer<U>& other) {
-        return SharedPointer<T>(static_cast<T*>(other.get()), other.use_count_ptr());
+    static SharedPointer static_pointer_cast(const SharedPointer<U, Counting>& other) {
+        SharedPointer result(static_cast<T*>(other.get()), other.control_block());
+        if (result.controlBlock) {
+            result.controlBlock->retain();
+        }
+        return result;
     }
 
 private:
 
-    SharedPointer(T* p, size_t* refCount) : pointer(p), referenceCount(refCount) {
-        if (referenceCount) {
-            ++(*referenceCount);
-        }
-    }
+    SharedPointer(T* p, ControlBlock* block) : pointer(p), controlBlock(block) {}
 };
 
 
-template<typename T>
-class SharedPointer<T[]> {
+template<typename T, typename Counting>
+class SharedPointer<T[], Counting> {
 
 private:
 
+    using ControlBlock = SharedControlBlock<Counting>;
+
     T* pointer;
-    size_t *referenceCount;
+    ControlBlock *controlBlock;
 
     void clean(){
-        if (referenceCount && --(*referenceCount) == 0) {
-            delete pointer[];
-            delete referenceCount;
+        if (!controlBlock) {
+            return;
+        }
+        if constexpr (isDeferredCounting<Counting>) {
+            if (deferredReleaseDepth) {
+                DeferredRelease::defer(controlBlock);
+                return;
+            }
+        }
+        if (controlBlock->release()) {
+            controlBlock->destroy();
         }
     }
 
+    template<typename U, typename C>
+    friend class SharedPointer;
+
 public:
 
-    explicit SharedPointer(T *p = nullptr) : pointer(p), referenceCount(new size_t(1)) {}
+    explicit SharedPointer(T *p = nullptr) : pointer(p), controlBlock(nullptr) {
+        if (p) {
+            try {
+                controlBlock = new SharedControlBlockArray<T, Counting>(p);
+            } catch (...) {
+                delete[] p;
+                throw;
+            }
+        }
+    }
+
+    template<typename Deleter, typename Allocator = std::allocator<T>>
+    SharedPointer(T *p, Deleter d, const Allocator &allocator = Allocator())
+    requires std::is_invocable_v<Deleter&, T*>
+            : pointer(p), controlBlock(nullptr) {
+        if (p) {
+            try {
+                controlBlock = allocateControlBlock<SharedControlBlockDeleter<T, Deleter, Allocator, Counting>>(
+                        allocator, p, std::move(d), allocator);
+            } catch (...) {
+                d(p);
+                throw;
+            }
+        }
+    }
 
     SharedPointer(const SharedPointer &other)
-            : pointer(other.pointer), referenceCount(other.referenceCount) {
-        if (referenceCount) {
-            ++(*referenceCount);
+            : pointer(other.pointer), controlBlock(other.controlBlock) {
+        if (controlBlock) {
+            controlBlock->retain();
         }
     }
 
@@ -120,15 +556,53 @@ public:
         if (this != &other) {
             clean();
             pointer = other.pointer;
-            referenceCount = other.referenceCount;
-            if (referenceCount) {
-                ++(*referenceCount);
+            controlBlock = other.controlBlock;
+            if (controlBlock) {
+                controlBlock->retain();
             }
         }
 
         return *this;
     }
 
+    SharedPointer(SharedPointer &&other) noexcept
+            : pointer(other.pointer), controlBlock(other.controlBlock) {
+        other.pointer = nullptr;
+        other.controlBlock = nullptr;
+    }
+
+    SharedPointer &operator=(SharedPointer &&other) noexcept {
+        T *p = other.pointer;
+        ControlBlock *block = other.controlBlock;
+        other.pointer = nullptr;
+        other.controlBlock = nullptr;
+        clean();
+        pointer = p;
+        controlBlock = block;
+        return *this;
+    }
+
+    template<typename U>
+    SharedPointer(SharedPointer<U[], Counting> &&other) noexcept
+    requires std::is_convertible_v<U(*)[], T(*)[]>
+            : pointer(static_cast<T*>(other.pointer)), controlBlock(other.controlBlock) {
+        other.pointer = nullptr;
+        other.controlBlock = nullptr;
+    }
+
+    template<typename U>
+    SharedPointer &operator=(SharedPointer<U[], Counting> &&other) noexcept
+    requires std::is_convertible_v<U(*)[], T(*)[]> {
+        T *p = static_cast<T*>(other.pointer);
+        ControlBlock *block = other.controlBlock;
+        other.pointer = nullptr;
+        other.controlBlock = nullptr;
+        clean();
+        pointer = p;
+        controlBlock = block;
+        return *this;
+    }
+
     ~SharedPointer() {
         clean();
     }
@@ -141,12 +615,11 @@ public:
         return pointer;
     }
 
-    size_t use_count() const { return referenceCount ? *referenceCount : 0; }
+    size_t use_count() const { return controlBlock ? controlBlock->count() : 0; }
 
+    // Builds the new block first, so a failed allocation leaves this pointer untouched.
     void reset(T *p = nullptr) {
-        clean();
-        pointer = p;
-        referenceCount = new size_t(1);
+        *this = SharedPointer(p);
     }
 
     bool null() const {
@@ -157,16 +630,34 @@ public:
         return pointer;
     }
 
+    ControlBlock* control_block() const {
+        return controlBlock;
+    }
+
     template<typename U>
-    static SharedPointer<T[]> static_pointer_cast(const SharedPointer<U[]>& other) {
-        return SharedPointer<T[]>(static_cast<T*>(other.get()), other.use_count_ptr());
+    static SharedPointer static_pointer_cast(const SharedPointer<U[], Counting>& other) {
+        SharedPointer result(static_cast<T*>(other.get()), other.control_block());
+        if (result.controlBlock) {
+            result.controlBlock->retain();
+        }
+        return result;
     }
 
 private:
 
-    SharedPointer(T* p, size_t* refCount) : pointer(p), referenceCount(refCount) {
-        if (referenceCount) {
-            ++(*referenceCount);
-        }
-    }
-};
\ No newline at end of file
+    SharedPointer(T* p, ControlBlock* block) : pointer(p), controlBlock(block) {}
+};
+
+
+template<typename T, typename Counting = NonAtomicCounting, typename... Args>
+SharedPointer<T, Counting> MakeShared(Args&&... args) {
+    auto *block = new SharedControlBlockInplace<T, Counting>(std::forward<Args>(args)...);
+    return SharedPointer<T, Counting>(block->get(), block);
+}
+
+template<typename T, typename Counting = NonAtomicCounting, typename Allocator, typename... Args>
+SharedPointer<T, Counting> AllocateShared(const Allocator& allocator, Args&&... args) {
+    auto *block = allocateControlBlock<SharedControlBlockInplaceAllocated<T, Allocator, Counting>>(
+            allocator, allocator, std::forward<Args>(args)...);
+    return SharedPointer<T, Counting>(block->get(), block);
+}
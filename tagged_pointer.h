@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+#include "unique_pointer.h"
+
+// A UniquePointer that keeps Bits bits of user data in the low bits of the
+// address, which are always zero because T is aligned to at least 2^Bits
+// bytes. The tag travels with the pointer on moves and is kept by reset(), so
+// a struct that paired a UniquePointer with a small flag fits in one word.
+template<typename T, unsigned Bits, typename Deleter = DefaultDelete<T>>
+class TaggedUniquePointer : private DeleterStorage<Deleter> {
+
+private:
+
+    using Storage = DeleterStorage<Deleter>;
+
+    static_assert(Bits > 0, "a tagged pointer needs at least one tag bit");
+    static_assert(!std::is_array_v<T>, "tagged pointers to arrays are not supported");
+
+    static constexpr uintptr_t tagMask = (uintptr_t(1) << Bits) - 1;
+
+    uintptr_t bits;
+
+    // Checked where T is complete, so a node can hold a tagged pointer to its own type.
+    static constexpr void checkAlignment() {
+        static_assert(alignof(T) >= (size_t(1) << Bits), "alignof(T) leaves fewer free low bits than Bits");
+    }
+
+    static uintptr_t pack(T *p, uintptr_t tag) {
+        checkAlignment();
+        assert((reinterpret_cast<uintptr_t>(p) & tagMask) == 0 && tag <= maxTag);
+        return reinterpret_cast<uintptr_t>(p) | tag;
+    }
+
+    void destroy() {
+        if (T *p = get()) {
+            get_deleter()(p);
+        }
+    }
+
+public:
+
+    static constexpr uintptr_t maxTag = tagMask;
+
+    // A pointer deleter would be left null, so it has to be passed explicitly.
+    explicit TaggedUniquePointer(T *p = nullptr, uintptr_t tag = 0) requires (!std::is_pointer_v<Deleter>)
+            : bits(pack(p, tag)) {}
+
+    TaggedUniquePointer(T *p, uintptr_t tag, const Deleter &d) : Storage(d), bits(pack(p, tag)) {}
+
+    explicit TaggedUniquePointer(UniquePointer<T, Deleter> &&other, uintptr_t tag = 0)
+            : Storage(std::forward<Deleter>(other.get_deleter())), bits(pack(other.release(), tag)) {}
+
+    ~TaggedUniquePointer() {
+        destroy();
+    }
+
+    TaggedUniquePointer(const TaggedUniquePointer &) = delete;
+    TaggedUniquePointer &operator=(const TaggedUniquePointer &) = delete;
+
+    TaggedUniquePointer(TaggedUniquePointer &&other) noexcept
+            : Storage(std::forward<Deleter>(other.get_deleter())), bits(other.bits) {
+        other.bits = 0;
+    }
+
+    TaggedUniquePointer &operator=(TaggedUniquePointer &&other) noexcept {
+        if (this != &other) {
+            destroy();
+            bits = other.bits;
+            other.bits = 0;
+            get_deleter() = std::forward<Deleter>(other.get_deleter());
+        }
+
+        return *this;
+    }
+
+    T &operator*() const {
+        return *get();
+    }
+
+    T *operator->() const {
+        return get();
+    }
+
+    void reset(T *p = nullptr) {
+        destroy();
+        bits = pack(p, tag());
+    }
+
+    T *release() {
+        T *tmp = get();
+        bits &= tagMask;
+        return tmp;
+    }
+
+    bool null() const {
+        return get() == nullptr;
+    }
+
+    T *get() const {
+        return reinterpret_cast<T *>(bits & ~tagMask);
+    }
+
+    uintptr_t tag() const {
+        return bits & tagMask;
+    }
+
+    void set_tag(uintptr_t tag) {
+        assert(tag <= maxTag);
+        bits = (bits & ~tagMask) | tag;
+    }
+
+    Deleter &get_deleter() {
+        return Storage::deleter();
+    }
+
+    const Deleter &get_deleter() const {
+        return Storage::deleter();
+    }
+};
@@ -1,22 +1,59 @@
+#include "hazard_pointer.h"
+#include "intrusive_pointer.h"
 #include "shared_pointer.h"
+#include "tagged_pointer.h"
 #include "unique_pointer.h"
+#include "pool_allocator.h"
 
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
 
-template<typename T>
+
+// Link for the unique pointer list that keeps two flag bits in the pointer. The
+// tag on a link holds the flags of the node it points to, so moving a link
+// carries the flags along and push and pop keep every node's flags intact.
+template<typename Node>
+using TaggedLink = TaggedUniquePointer<Node, 2>;
+
+template<typename T, typename Allocator = NewDeleteAllocator, template<typename...> class Link = UniquePointer>
 struct NodeUniquePointer {
 
     T data;
-    UniquePointer<NodeUniquePointer<T>> next;
+    Link<NodeUniquePointer> next;
 
     explicit NodeUniquePointer(T val) : data(val), next(nullptr) {}
+
+    // Unlinks the rest of the chain in a loop instead of recursing once per node.
+    ~NodeUniquePointer() {
+        Link<NodeUniquePointer> current = std::move(next);
+        while (!current.null()) {
+            Link<NodeUniquePointer> following = std::move(current->next);
+            current = std::move(following);
+        }
+    }
+
+    static void* operator new(size_t) {
+        return Allocator::template allocate<NodeUniquePointer>();
+    }
+
+    static void operator delete(void* p) {
+        Allocator::template deallocate<NodeUniquePointer>(p);
+    }
 };
 
-template<typename T>
+template<typename T, typename Allocator = NewDeleteAllocator, template<typename...> class Link = UniquePointer>
 class LinkedListUniquePointer {
 
 private:
 
-    UniquePointer<NodeUniquePointer<T>> head;
+    using Node = NodeUniquePointer<T, Allocator, Link>;
+    using Pointer = Link<Node>;
+
+    static constexpr bool flagged = requires (const Pointer &link) { link.tag(); };
+
+    Pointer head;
     size_t length;
 
 public:
@@ -24,7 +61,14 @@ public:
     LinkedListUniquePointer() : head(nullptr), length(0) {}
 
     void push_front(const T& value) {
-        UniquePointer<NodeUniquePointer<T>> newNode = UniquePointer<NodeUniquePointer<T>>(new NodeUniquePointer<T>(value));
+        Pointer newNode = Pointer(new Node(value));
+        newNode->next = std::move(head);
+        head = std::move(newNode);
+        ++length;
+    }
+
+    void push_front(const T& value, uintptr_t flags) requires flagged {
+        Pointer newNode = Pointer(new Node(value), flags);
         newNode->next = std::move(head);
         head = std::move(newNode);
         ++length;
@@ -36,7 +80,7 @@ public:
 
     void pop_front() {
         if (!head.null()) {
-            UniquePointer<NodeUniquePointer<T>> oldHead = std::move(head);
+            Pointer oldHead = std::move(head);
             head = std::move(oldHead->next);
             --length;
         }
@@ -46,40 +90,87 @@ public:
         return length;
     }
 
-    void clear() {
-        while (!head.null()) {
-            pop_front();
+    template<typename Function>
+    void for_each(Function function) const {
+        for (Node* node = head.get(); node; node = node->next.get()) {
+            function(node->data);
+        }
+    }
+
+    // Calls function(data, flags) for every node, front to back.
+    template<typename Function>
+    void for_each_flagged(Function function) const requires flagged {
+        uintptr_t flags = head.tag();
+        for (Node* node = head.get(); node; node = node->next.get()) {
+            function(node->data, flags);
+            flags = node->next.tag();
         }
     }
 
+    void clear() {
+        // Assigning rather than resetting also drops the front flags of a tagged link.
+        head = Pointer();
+        length = 0;
+    }
+
     ~LinkedListUniquePointer(){
         clear();
     }
 
     T& get_front() const {
-        if(!head.null()){
-            return head->data;
-        }
+        return head->data;
+    }
+
+    uintptr_t front_flags() const requires flagged {
+        return head.tag();
+    }
+
+    void set_front_flags(uintptr_t flags) requires flagged {
+        head.set_tag(flags);
     }
 
 };
 
 
-template<typename T>
+template<typename T, typename Allocator = NewDeleteAllocator>
 struct NodeSharedPointer {
 
+    // The list allocates each node's control block through the same Allocator.
+    using BlockAllocator = StaticAllocatorAdapter<NodeSharedPointer, Allocator>;
+    using ControlBlock = SharedControlBlockDeleter<NodeSharedPointer, DefaultDelete<NodeSharedPointer>, BlockAllocator,
+                                                   NonAtomicCounting>;
+
     T data;
-    SharedPointer<NodeSharedPointer<T>> next;
+    SharedPointer<NodeSharedPointer> next;
 
     explicit NodeSharedPointer(T val) : data(val), next(nullptr) {}
+
+    // Unlinks iteratively and stops at the first node still shared with another owner.
+    ~NodeSharedPointer() {
+        SharedPointer<NodeSharedPointer> current = std::move(next);
+        while (!current.null() && current.use_count() == 1) {
+            SharedPointer<NodeSharedPointer> following = std::move(current->next);
+            current = std::move(following);
+        }
+    }
+
+    static void* operator new(size_t) {
+        return Allocator::template allocate<NodeSharedPointer>();
+    }
+
+    static void operator delete(void* p) {
+        Allocator::template deallocate<NodeSharedPointer>(p);
+    }
 };
 
-template<typename T>
+template<typename T, typename Allocator = NewDeleteAllocator>
 class LinkedListSharedPointer {
 
 private:
 
-    SharedPointer<NodeSharedPointer<T>> head;
+    using Node = NodeSharedPointer<T, Allocator>;
+
+    SharedPointer<Node> head;
     size_t length;
 
 public:
@@ -87,7 +178,8 @@ public:
     LinkedListSharedPointer() : head(nullptr), length(0) {}
 
     void push_front(const T& value) {
-        SharedPointer<NodeSharedPointer<T>> newNode = SharedPointer<NodeSharedPointer<T>>(new NodeSharedPointer<T>(value));
+        SharedPointer<Node> newNode = SharedPointer<Node>(new Node(value), DefaultDelete<Node>(),
+                                                          typename Node::BlockAllocator());
         newNode->next = std::move(head);
         head = std::move(newNode);
         ++length;
@@ -99,7 +191,7 @@ public:
 
     void pop_front() {
         if (!head.null()) {
-            SharedPointer<NodeSharedPointer<T>> oldHead = std::move(head);
+            SharedPointer<Node> oldHead = std::move(head);
             head = std::move(oldHead->next);
             --length;
         }
@@ -109,19 +201,375 @@ public:
         return length;
     }
 
-    void clear() {
-        while (!head.null()) {
-            pop_front();
+    template<typename Function>
+    void for_each(Function function) const {
+        for (Node* node = head.get(); node; node = node->next.get()) {
+            function(node->data);
         }
     }
 
+    void clear() {
+        head.reset();
+        length = 0;
+    }
+
     ~LinkedListSharedPointer(){
         clear();
     }
 
     T& get_front() const {
-        if(!head.null()){
-            return head->data;
+        return head->data;
+    }
+
+};
+
+
+template<typename T, typename Allocator = NewDeleteAllocator>
+struct NodeIntrusivePointer : IntrusiveCounted<NodeIntrusivePointer<T, Allocator>> {
+
+    T data;
+    IntrusivePointer<NodeIntrusivePointer> next;
+
+    explicit NodeIntrusivePointer(T val) : data(val), next(nullptr) {}
+
+    // Same iterative teardown as NodeSharedPointer, with the count read from the node itself.
+    ~NodeIntrusivePointer() {
+        IntrusivePointer<NodeIntrusivePointer> current = std::move(next);
+        while (!current.null() && current.use_count() == 1) {
+            IntrusivePointer<NodeIntrusivePointer> following = std::move(current->next);
+            current = std::move(following);
+        }
+    }
+
+    static void* operator new(size_t) {
+        return Allocator::template allocate<NodeIntrusivePointer>();
+    }
+
+    static void operator delete(void* p) {
+        Allocator::template deallocate<NodeIntrusivePointer>(p);
+    }
+};
+
+template<typename T, typename Allocator = NewDeleteAllocator>
+class LinkedListIntrusivePointer {
+
+private:
+
+    using Node = NodeIntrusivePointer<T, Allocator>;
+
+    IntrusivePointer<Node> head;
+    size_t length;
+
+public:
+
+    LinkedListIntrusivePointer() : head(nullptr), length(0) {}
+
+    void push_front(const T& value) {
+        IntrusivePointer<Node> newNode = IntrusivePointer<Node>(new Node(value));
+        newNode->next = std::move(head);
+        head = std::move(newNode);
+        ++length;
+    }
+
+    bool null(){
+        return head.null();
+    }
+
+    void pop_front() {
+        if (!head.null()) {
+            IntrusivePointer<Node> oldHead = std::move(head);
+            head = std::move(oldHead->next);
+            --length;
+        }
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    template<typename Function>
+    void for_each(Function function) const {
+        for (Node* node = head.get(); node; node = node->next.get()) {
+            function(node->data);
+        }
+    }
+
+    void clear() {
+        head.reset();
+        length = 0;
+    }
+
+    ~LinkedListIntrusivePointer(){
+        clear();
+    }
+
+    T& get_front() const {
+        return head->data;
+    }
+
+};
+
+
+template<typename T, size_t Capacity, typename Allocator = NewDeleteAllocator>
+struct NodeUnrolled {
+
+    static_assert(Capacity > 0, "an unrolled node must hold at least one element");
+
+    T data[Capacity];
+    size_t count;
+    UniquePointer<NodeUnrolled> next;
+
+    NodeUnrolled() : data(), count(0), next(nullptr) {}
+
+    ~NodeUnrolled() {
+        UniquePointer<NodeUnrolled> current = std::move(next);
+        while (!current.null()) {
+            UniquePointer<NodeUnrolled> following = std::move(current->next);
+            current = std::move(following);
+        }
+    }
+
+    static void* operator new(size_t) {
+        return Allocator::template allocate<NodeUnrolled>();
+    }
+
+    static void operator delete(void* p) {
+        Allocator::template deallocate<NodeUnrolled>(p);
+    }
+};
+
+// Keeps up to Capacity elements per node, so one allocation and one pointer
+// chase serve Capacity elements. The front element is the last one filled in
+// the head node.
+template<typename T, size_t Capacity = 16, typename Allocator = NewDeleteAllocator>
+class LinkedListUnrolled {
+
+private:
+
+    using Node = NodeUnrolled<T, Capacity, Allocator>;
+
+    UniquePointer<Node> head;
+    size_t length;
+
+public:
+
+    LinkedListUnrolled() : head(nullptr), length(0) {}
+
+    void push_front(const T& value) {
+        if (head.null() || head->count == Capacity) {
+            UniquePointer<Node> newNode = UniquePointer<Node>(new Node());
+            newNode->next = std::move(head);
+            head = std::move(newNode);
+        }
+        head->data[head->count++] = value;
+        ++length;
+    }
+
+    bool null(){
+        return head.null();
+    }
+
+    void pop_front() {
+        if (!head.null()) {
+            if (--head->count == 0) {
+                UniquePointer<Node> oldHead = std::move(head);
+                head = std::move(oldHead->next);
+            }
+            --length;
+        }
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    template<typename Function>
+    void for_each(Function function) const {
+        for (Node* node = head.get(); node; node = node->next.get()) {
+            for (size_t i = node->count; i > 0; --i) {
+                function(node->data[i - 1]);
+            }
+        }
+    }
+
+    void clear() {
+        head.reset();
+        length = 0;
+    }
+
+    ~LinkedListUnrolled(){
+        clear();
+    }
+
+    T& get_front() const {
+        return head->data[head->count - 1];
+    }
+
+};
+
+
+// Nodes live side by side in two arrays, values and 32-bit "next" indices,
+// instead of in separate heap blocks. Popped slots go onto a free list
+// threaded through the same index array and are reused by push_front.
+template<typename T>
+class LinkedListIndexed {
+
+private:
+
+    using Index = uint32_t;
+
+    static constexpr Index none = UINT32_MAX;
+
+    std::vector<T> values;
+    std::vector<Index> links;
+    Index head;
+    Index freeList;
+    size_t length;
+
+public:
+
+    LinkedListIndexed() : head(none), freeList(none), length(0) {}
+
+    void push_front(const T& value) {
+        Index slot;
+        if (freeList != none) {
+            slot = freeList;
+            freeList = links[slot];
+            values[slot] = value;
+            links[slot] = head;
+        } else {
+            if (values.size() == none) {
+                throw std::length_error("LinkedListIndexed is full");
+            }
+            slot = Index(values.size());
+            values.push_back(value);
+            links.push_back(head);
+        }
+        head = slot;
+        ++length;
+    }
+
+    bool null(){
+        return head == none;
+    }
+
+    void pop_front() {
+        if (head != none) {
+            Index oldHead = head;
+            head = links[oldHead];
+            links[oldHead] = freeList;
+            freeList = oldHead;
+            --length;
+        }
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    template<typename Function>
+    void for_each(Function function) const {
+        for (Index index = head; index != none; index = links[index]) {
+            function(values[index]);
+        }
+    }
+
+    // Frees both arrays, like the pointer lists free their nodes.
+    void clear() {
+        std::vector<T>().swap(values);
+        std::vector<Index>().swap(links);
+        head = none;
+        freeList = none;
+        length = 0;
+    }
+
+    T& get_front() {
+        return values[head];
+    }
+
+    const T& get_front() const {
+        return values[head];
+    }
+
+};
+
+
+// Treiber stack shared by any number of threads: push_front and pop_front swing
+// the head with a compare-and-swap. Popped nodes go through HazardPointers, so a
+// node is never freed, and its address never reused, while another thread is
+// still reading it.
+template<typename T>
+class ConcurrentStack {
+
+private:
+
+    struct Node {
+
+        T data;
+        Node* next;
+
+        explicit Node(const T& val) : data(val), next(nullptr) {}
+    };
+
+    std::atomic<Node*> head;
+    std::atomic<size_t> length;
+
+public:
+
+    ConcurrentStack() : head(nullptr), length(0) {}
+
+    ConcurrentStack(const ConcurrentStack&) = delete;
+    ConcurrentStack& operator=(const ConcurrentStack&) = delete;
+
+    void push_front(const T& value) {
+        Node* newNode = new Node(value);
+        newNode->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(newNode->next, newNode, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        }
+        length.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Returns false if the stack was empty.
+    bool pop_front(T& value) {
+        Node* oldHead = head.load(std::memory_order_acquire);
+        while (oldHead) {
+            HazardPointers::protect(oldHead);
+            Node* current = head.load(std::memory_order_seq_cst);
+            if (current != oldHead) {
+                oldHead = current;
+                continue;
+            }
+            if (head.compare_exchange_weak(oldHead, oldHead->next, std::memory_order_acquire,
+                                           std::memory_order_acquire)) {
+                break;
+            }
+        }
+        HazardPointers::clear();
+        if (!oldHead) {
+            return false;
+        }
+        length.fetch_sub(1, std::memory_order_relaxed);
+        value = std::move(oldHead->data);
+        HazardPointers::retire(oldHead);
+        return true;
+    }
+
+    bool null() const {
+        return head.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // Exact only while no other thread is pushing or popping.
+    size_t size() const {
+        return length.load(std::memory_order_relaxed);
+    }
+
+    ~ConcurrentStack() {
+        Node* node = head.load(std::memory_order_relaxed);
+        while (node) {
+            Node* next = node->next;
+            delete node;
+            node = next;
         }
     }
 
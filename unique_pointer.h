@@ -1,51 +1,170 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
 #include <utility>
 #include <type_traits>
 
 template<typename T>
-class UniquePointer {
+struct DefaultDelete {
+
+    DefaultDelete() = default;
+
+    template<typename U>
+    DefaultDelete(const DefaultDelete<U> &)
+    requires std::is_convertible_v<U*, T*> {}
+
+    void operator()(T *p) const {
+        delete p;
+    }
+};
+
+template<typename T>
+struct DefaultDelete<T[]> {
+
+    DefaultDelete() = default;
+
+    template<typename U>
+    DefaultDelete(const DefaultDelete<U[]> &)
+    requires std::is_convertible_v<U(*)[], T(*)[]> {}
+
+    void operator()(T *p) const {
+        delete[] p;
+    }
+};
+
+// Frees arrays made by MakeUniqueArray: destroys the recorded number of
+// elements, then releases storage aligned to at least a cache line. Also
+// gives UniquePointer<T[]> its size(), begin()/end() and at().
+template<typename T>
+class AlignedArrayDelete {
+
+private:
+
+    std::size_t length;
+
+public:
+
+    static constexpr std::size_t alignment = alignof(T) > 64 ? alignof(T) : 64;
+
+    explicit AlignedArrayDelete(std::size_t n = 0) : length(n) {}
+
+    void operator()(T *p) const {
+        std::destroy_n(p, length);
+        ::operator delete(p, std::align_val_t(alignment));
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+};
+
+// Empty deleters are stored as a base class so they take no space.
+template<typename Deleter, bool Empty = std::is_empty_v<Deleter> && !std::is_final_v<Deleter>>
+class DeleterStorage : private Deleter {
+
+public:
+
+    DeleterStorage() = default;
+
+    template<typename D>
+    explicit DeleterStorage(D &&d) : Deleter(std::forward<D>(d)) {}
+
+    Deleter &deleter() {
+        return *this;
+    }
+
+    const Deleter &deleter() const {
+        return *this;
+    }
+};
+
+template<typename Deleter>
+class DeleterStorage<Deleter, false> {
+
+private:
+
+    Deleter stored;
+
+public:
+
+    DeleterStorage() = default;
+
+    template<typename D>
+    explicit DeleterStorage(D &&d) : stored(std::forward<D>(d)) {}
+
+    Deleter &deleter() {
+        return stored;
+    }
+
+    const Deleter &deleter() const {
+        return stored;
+    }
+};
+
+
+template<typename T, typename Deleter = DefaultDelete<T>>
+class UniquePointer : private DeleterStorage<Deleter> {
 
 private:
 
+    using Storage = DeleterStorage<Deleter>;
+
     T *pointer;
 
+    void destroy() {
+        if (pointer) {
+            get_deleter()(pointer);
+        }
+    }
+
 public:
 
-    explicit UniquePointer(T *p = nullptr) : pointer(p) {}
+    // A pointer deleter would be left null, so it has to be passed explicitly.
+    explicit UniquePointer(T *p = nullptr) requires (!std::is_pointer_v<Deleter>) : pointer(p) {}
+
+    UniquePointer(T *p, const Deleter &d) : Storage(d), pointer(p) {}
+
+    UniquePointer(T *p, Deleter &&d) requires (!std::is_reference_v<Deleter>) : Storage(std::move(d)), pointer(p) {}
+
     ~UniquePointer() {
-        delete pointer;
+        destroy();
     }
 
     UniquePointer(const UniquePointer &) = delete;
     UniquePointer &operator=(const UniquePointer &) = delete;
 
-    UniquePointer(UniquePointer &&other) noexcept : pointer(other.pointer) {
+    UniquePointer(UniquePointer &&other) noexcept
+            : Storage(std::forward<Deleter>(other.get_deleter())), pointer(other.pointer) {
         other.pointer = nullptr;
     }
 
     UniquePointer &operator=(UniquePointer &&other) noexcept {
         if (this != &other) {
-            delete pointer;
+            destroy();
             pointer = other.pointer;
             other.pointer = nullptr;
+            get_deleter() = std::forward<Deleter>(other.get_deleter());
         }
 
         return *this;
     }
 
-    template<typename U>
-    UniquePointer(UniquePointer<U> &&other) noexcept
-    requires std::is_convertible_v<U*, T*>
-            : pointer(static_cast<T*>(other.release())) {}
+    template<typename U, typename E>
+    UniquePointer(UniquePointer<U, E> &&other) noexcept
+    requires std::is_convertible_v<U*, T*> && std::is_convertible_v<E, Deleter>
+            : Storage(std::forward<E>(other.get_deleter())), pointer(static_cast<T*>(other.release())) {}
 
-    template<typename U>
-    UniquePointer &operator=(UniquePointer<U> &&other) noexcept
-    requires std::is_convertible_v<U*, T*> {
+    template<typename U, typename E>
+    UniquePointer &operator=(UniquePointer<U, E> &&other) noexcept
+    requires std::is_convertible_v<U*, T*> && std::is_assignable_v<Deleter &, E &&> {
         if (this != reinterpret_cast<UniquePointer*>(&other)) {
-            delete pointer;
+            destroy();
             pointer = static_cast<T*>(other.release());
+            get_deleter() = std::forward<E>(other.get_deleter());
         }
         return *this;
     }
@@ -63,7 +182,7 @@ public:
     }
 
     void reset(T *p = nullptr) {
-        delete pointer;
+        destroy();
         pointer = p;
     }
 
@@ -80,50 +199,78 @@ public:
     T* get() const {
         return pointer;
     }
+
+    Deleter &get_deleter() {
+        return Storage::deleter();
+    }
+
+    const Deleter &get_deleter() const {
+        return Storage::deleter();
+    }
 };
 
-template<typename T>
-class UniquePointer<T[]> {
+template<typename T, typename Deleter>
+class UniquePointer<T[], Deleter> : private DeleterStorage<Deleter> {
 
 private:
 
+    using Storage = DeleterStorage<Deleter>;
+
+    // A deleter that knows the array length, such as AlignedArrayDelete.
+    static constexpr bool sized = requires (const Deleter &d) { d.size(); };
+
     T *pointer;
 
+    void destroy() {
+        if (pointer) {
+            get_deleter()(pointer);
+        }
+    }
+
 public:
 
-    explicit UniquePointer(T *p = nullptr) : pointer(p) {}
+    // A pointer deleter would be left null, so it has to be passed explicitly.
+    explicit UniquePointer(T *p = nullptr) requires (!std::is_pointer_v<Deleter>) : pointer(p) {}
+
+    UniquePointer(T *p, const Deleter &d) : Storage(d), pointer(p) {}
+
+    UniquePointer(T *p, Deleter &&d) requires (!std::is_reference_v<Deleter>) : Storage(std::move(d)), pointer(p) {}
+
     ~UniquePointer() {
-        delete[] pointer;
+        destroy();
     }
 
     UniquePointer(const UniquePointer &) = delete;
     UniquePointer &operator=(const UniquePointer &) = delete;
 
-    UniquePointer(UniquePointer &&other) noexcept : pointer(other.pointer) {
+    UniquePointer(UniquePointer &&other) noexcept
+            : Storage(std::forward<Deleter>(other.get_deleter())), pointer(other.pointer) {
         other.pointer = nullptr;
     }
 
     UniquePointer &operator=(UniquePointer &&other) noexcept {
         if (this != &other) {
-            delete[] pointer;
+            destroy();
             pointer = other.pointer;
             other.pointer = nullptr;
+            get_deleter() = std::forward<Deleter>(other.get_deleter());
         }
 
         return *this;
     }
 
-    template<typename U>
-    UniquePointer(UniquePointer<U[]> &&other) noexcept
-    requires std::is_convertible_v<U*, T*>
-            : pointer(static_cast<T*>(other.release())) {}
+    template<typename U, typename E>
+    UniquePointer(UniquePointer<U[], E> &&other) noexcept
+    requires std::is_convertible_v<U*, T*> && std::is_convertible_v<E, Deleter>
+            : Storage(std::forward<E>(other.get_deleter())), pointer(static_cast<T*>(other.release())) {}
 
-    template<typename U>
-    UniquePointer &operator=(UniquePointer<U[]> &&other) noexcept
-    requires std::is_convertible_v<U*, T*> {
+    template<typename U, typename E>
+    UniquePointer &operator=(UniquePointer<U[], E> &&other) noexcept
+    requires std::is_convertible_v<U*, T*> && std::is_assignable_v<Deleter &, E &&> {
         if (this != reinterpret_cast<UniquePointer*>(&other)) {
-            delete[] pointer;
+            destroy();
             pointer = static_cast<T*>(other.release());
+            get_deleter() = std::forward<E>(other.get_deleter());
         }
         return *this;
     }
@@ -140,11 +287,18 @@ public:
         return pointer[index];
     }
 
-    void reset(T *p = nullptr) {
-        delete[] pointer;
+    void reset(T *p = nullptr) requires (!sized) {
+        destroy();
         pointer = p;
     }
 
+    // A sized deleter would keep the old length and allocation scheme for a new
+    // array, so only emptying is allowed; assign another array to replace it.
+    void reset(std::nullptr_t = nullptr) requires sized {
+        destroy();
+        pointer = nullptr;
+    }
+
     T *release() {
         T *tmp = pointer;
         pointer = nullptr;
@@ -158,4 +312,66 @@ public:
     T* get() const {
         return pointer;
     }
+
+    std::size_t size() const requires sized {
+        return pointer ? get_deleter().size() : 0;
+    }
+
+    T *begin() const requires sized {
+        return pointer;
+    }
+
+    T *end() const requires sized {
+        return pointer + size();
+    }
+
+    T &at(std::size_t index) const requires sized {
+        if (index >= size()) {
+            throw std::out_of_range("UniquePointer<T[]>::at: index out of range");
+        }
+        return pointer[index];
+    }
+
+    Deleter &get_deleter() {
+        return Storage::deleter();
+    }
+
+    const Deleter &get_deleter() const {
+        return Storage::deleter();
+    }
 };
+
+template<typename T>
+using UniqueArray = UniquePointer<T[], AlignedArrayDelete<T>>;
+
+template<typename T, typename Construct>
+UniqueArray<T> allocateAlignedArray(std::size_t n, Construct construct) {
+    if (n > SIZE_MAX / sizeof(T)) {
+        throw std::bad_array_new_length();
+    }
+    T *p = static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(AlignedArrayDelete<T>::alignment)));
+    try {
+        construct(p, n);
+    } catch (...) {
+        ::operator delete(p, std::align_val_t(AlignedArrayDelete<T>::alignment));
+        throw;
+    }
+    return UniqueArray<T>(p, AlignedArrayDelete<T>(n));
+}
+
+// n value-initialised elements, like new T[n]() but aligned and sized.
+template<typename T>
+UniqueArray<T> MakeUniqueArray(std::size_t n) {
+    return allocateAlignedArray<T>(n, [](T *p, std::size_t count) {
+        std::uninitialized_value_construct_n(p, count);
+    });
+}
+
+// n default-initialised elements: trivial types are left unwritten, so pages
+// are only touched when the caller fills them.
+template<typename T>
+UniqueArray<T> MakeUniqueArrayForOverwrite(std::size_t n) {
+    return allocateAlignedArray<T>(n, [](T *p, std::size_t count) {
+        std::uninitialized_default_construct_n(p, count);
+    });
+}
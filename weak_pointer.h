@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "shared_pointer.h"
+
+template<typename T, typename Counting = NonAtomicCounting>
+class WeakPointer {
+
+private:
+
+    using ControlBlock = SharedControlBlock<Counting>;
+
+    T* pointer;
+    ControlBlock* controlBlock;
+
+    void clean() {
+        if (controlBlock) {
+            controlBlock->releaseWeak();
+        }
+    }
+
+    template<typename U, typename C>
+    friend class WeakPointer;
+
+public:
+
+    WeakPointer() : pointer(nullptr), controlBlock(nullptr) {}
+
+    template<typename U>
+    WeakPointer(const SharedPointer<U, Counting>& shared)
+    requires std::is_convertible_v<U*, T*>
+            : pointer(shared.get()), controlBlock(shared.control_block()) {
+        if (controlBlock) {
+            controlBlock->retainWeak();
+        }
+    }
+
+    WeakPointer(const WeakPointer& other) : pointer(other.pointer), controlBlock(other.controlBlock) {
+        if (controlBlock) {
+            controlBlock->retainWeak();
+        }
+    }
+
+    WeakPointer& operator=(const WeakPointer& other) {
+        if (this != &other) {
+            clean();
+            pointer = other.pointer;
+            controlBlock = other.controlBlock;
+            if (controlBlock) {
+                controlBlock->retainWeak();
+            }
+        }
+        return *this;
+    }
+
+    WeakPointer(WeakPointer&& other) noexcept : pointer(other.pointer), controlBlock(other.controlBlock) {
+        other.pointer = nullptr;
+        other.controlBlock = nullptr;
+    }
+
+    WeakPointer& operator=(WeakPointer&& other) noexcept {
+        T* p = other.pointer;
+        ControlBlock* block = other.controlBlock;
+        other.pointer = nullptr;
+        other.controlBlock = nullptr;
+        clean();
+        pointer = p;
+        controlBlock = block;
+        return *this;
+    }
+
+    template<typename U>
+    WeakPointer& operator=(const SharedPointer<U, Counting>& shared)
+    requires std::is_convertible_v<U*, T*> {
+        return *this = WeakPointer(shared);
+    }
+
+    ~WeakPointer() {
+        clean();
+    }
+
+    size_t use_count() const {
+        return controlBlock ? controlBlock->count() : 0;
+    }
+
+    bool expired() const {
+        return use_count() == 0;
+    }
+
+    SharedPointer<T, Counting> lock() const {
+        if (controlBlock && controlBlock->retainIfAlive()) {
+            return SharedPointer<T, Counting>(pointer, controlBlock);
+        }
+        return SharedPointer<T, Counting>();
+    }
+
+    void reset() {
+        clean();
+        pointer = nullptr;
+        controlBlock = nullptr;
+    }
+};